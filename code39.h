@@ -9,7 +9,7 @@
  * le caractère « 0 »). Il est suivi d'une représentation du codage sous la 
  * forme d'une séquence de barres étroites (« N ») et larges (« W »).
  */
-const char code39[44][10]= {
+constexpr char code39[44][10]= {
       {'0','N','N','N','W','W','N','W','N','N'},
       {'1','W','N','N','W','N','N','N','N','W'},
       {'2','N','N','W','W','N','N','N','N','W'},
@@ -0,0 +1,185 @@
+/*
+ *Edge tracking for the two outer sensors, each on its own. Requiring both
+ *outers to see black at once only works when the robot is square to the
+ *bars: rotated even slightly, one sensor reaches every edge before the other,
+ *so black bars read short and white ones long by the difference.
+ *
+ *Instead each sensor keeps its own queue of edges (encoder position of every
+ *color change). An element is done once both sensors have passed its far
+ *edge; its width is the average of the two sensors' widths, and the offset
+ *between the two sensors' edges over the distance between them gives the skew
+ *of the robot against the bars. Each stream also filters its own sensor's
+ *readings (SchmittFilter), so a sensor only ever changes color against its
+ *own last color, never against the element being measured, which the other
+ *sensor may not have reached yet.
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef EDGESTREAMS_H
+#define EDGESTREAMS_H
+
+#include <stdint.h>
+#include "fixedpoint.h"
+#include "params.h"
+
+const uint8_t EDGE_QUEUE = 8; //edges one sensor may get ahead of the other
+//Outer sensor Schmitt band (calibrated readings are already scaled to each
+//sensor's own min/max, so one band suits both)
+const int16_t EDGE_BLACK_ABOVE = BLACK_EDGE_MIN + EDGE_HYSTERESIS;
+const int16_t EDGE_WHITE_BELOW = BLACK_EDGE_MIN - EDGE_HYSTERESIS;
+static_assert(EDGE_WHITE_BELOW > 0 && EDGE_BLACK_ABOVE < 1000,
+              "EDGE_HYSTERESIS band runs off the calibrated range");
+
+//Turns one outer sensor's readings into a color: a first-order IIR filter
+//takes the sample noise off, then a Schmitt trigger with a band either side of
+//the threshold decides, so a reading hovering at the threshold can't flip the
+//color back and forth and an edge counts on the sample it is crossed. The
+//filter needs as many samples to climb from white past the top of the band as
+//to fall from black past the bottom only if the band is centred on the middle
+//of the range (500); off centre, every bar reads wider or narrower by the
+//difference
+struct SchmittFilter {
+  int16_t level; // filtered reading
+  uint8_t color; // 0=black 1=white
+
+  void begin(uint16_t v, uint8_t c) {
+    level = (int16_t) v;
+    color = c;
+  }
+
+  /*
+   *v: calibrated reading (0-1000)
+   *low, high: white below low, black above high, no change in between
+   *shift: filter weight of the new reading is 1/2^shift
+   *returns: color after this reading
+   */
+  uint8_t see(uint16_t v, int16_t low, int16_t high, uint8_t shift) {
+    level += ((int16_t) v - level) >> shift;
+    if (color == 1 && level > high) color = 0;
+    else if (color == 0 && level < low) color = 1;
+    return color;
+  }
+};
+
+//Edges seen by one outer sensor, in encoder ticks
+struct EdgeStream {
+  SchmittFilter filter;   // this sensor's color, 0=black 1=white
+  long lastEdge;          // where the element being measured started
+  long edges[EDGE_QUEUE]; // edges not yet paired with the other sensor
+  uint8_t head, count;
+
+  void begin(uint8_t c, long pos) {
+    filter.begin((c == 1) ? 0 : 1000, c);
+    lastEdge = pos;
+    head = count = 0;
+  }
+
+  long newest() const {
+    return (count > 0) ? edges[(head + count - 1) % EDGE_QUEUE] : lastEdge;
+  }
+
+  /*
+   *Filters one reading and records an edge if the sensor's color changed. An
+   *edge that comes back within minTicks of one still queued is flicker: both
+   *are dropped
+   *v: calibrated reading (0-1000)
+   *returns: false if the queue is full
+   */
+  bool see(uint16_t v, long pos, long minTicks) {
+    uint8_t was = filter.color;
+    uint8_t c = filter.see(v, EDGE_WHITE_BELOW, EDGE_BLACK_ABOVE, FILTER_SHIFT);
+    if (c == was) return true;
+    if (count > 0 && pos - newest() < minTicks) {
+      count--;
+      return true;
+    }
+    if (count == EDGE_QUEUE) return false;
+    edges[(head + count) % EDGE_QUEUE] = pos;
+    count++;
+    return true;
+  }
+
+  /*
+   *returns: width of the element ending at the oldest queued edge
+   */
+  long take() {
+    long w = edges[head] - lastEdge;
+    lastEdge = edges[head];
+    head = (head + 1) % EDGE_QUEUE;
+    count--;
+    return w;
+  }
+};
+
+class OuterEdges {
+ public:
+  /*
+   *Starts both streams at pos, in the middle of an element of color c
+   */
+  void begin(uint8_t c, long pos) {
+    left.begin(c, pos);
+    right.begin(c, pos);
+    current = c;
+  }
+
+  /*
+   *Feeds one sample of both sensors
+   *readLeft, readRight: calibrated readings of s[0] and s[4]
+   *returns: false if one sensor got more than EDGE_QUEUE edges ahead
+   */
+  bool see(uint16_t readLeft, uint16_t readRight, long pos, long minTicks) {
+    bool ok = left.see(readLeft, pos, minTicks);
+    return right.see(readRight, pos, minTicks) && ok;
+  }
+
+  /*
+   *returns: true once both sensors have passed the end of the current element
+   *and held the new color for minTicks (so it can't be flicker any more)
+   */
+  bool ready(long pos, long minTicks) const {
+    if (left.count == 0 || right.count == 0) return false;
+    long l = left.edges[left.head], r = right.edges[right.head];
+    return pos - ((l > r) ? l : r) >= minTicks;
+  }
+
+  /*
+   *How far into the current element the robot is, from the later of the two
+   *sensors' edges
+   */
+  long travelled(long pos) const {
+    return pos - ((left.lastEdge > right.lastEdge) ? left.lastEdge
+                                                   : right.lastEdge);
+  }
+
+  /*
+   *returns: color of the element being measured, 0=black 1=white
+   */
+  uint8_t color() const {
+    return current;
+  }
+
+  /*
+   *Finishes the current element (only once ready())
+   *span: distance between the outer sensors, in ticks
+   *skewOut: angle of the robot against the bars at the element's far edge, in
+   *radians (counterclockwise positive, same as the gyro)
+   *returns: width of the element, averaged over both sensors
+   */
+  long take(long span, Width &skewOut) {
+    // Counterclockwise puts the right sensor ahead, so it sees the edge first
+    Width t = Width::fromRatio(left.edges[left.head] - right.edges[right.head],
+                               span);
+    skewOut = t - t * t * t / 3; // atan, small angles
+    long w = left.take() + right.take();
+    current = 1 - current;
+    return (w + 1) / 2;
+  }
+
+ private:
+  EdgeStream left, right;
+  uint8_t current;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ *Small fixed-point number type for the bar width pipeline. The ATmega32U4 has
+ *no FPU, so every float add/multiply/compare is a software routine; this keeps
+ *all width maths in plain integer instructions instead.
+ *
+ *FRAC_BITS picks the Q-format at compile time (Q15.16 for Fixed<16>). Values
+ *are stored in a signed 32-bit raw integer; products go through a 64-bit
+ *intermediate so nothing overflows for encoder-sized numbers. Divisions stay
+ *in 32 bits whenever the shifted dividend fits (libgcc's 64-bit divide is
+ *slower on the AVR than the float one this replaced), which covers every
+ *width in ticks.
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <stdint.h>
+
+template <uint8_t FRAC_BITS>
+struct Fixed {
+  static const uint8_t FRAC = FRAC_BITS;
+  static const int32_t ONE = (int32_t) 1 << FRAC_BITS;
+
+  int32_t raw;
+
+  /*
+   *Builds a value straight from its raw representation
+   */
+  static constexpr Fixed fromRaw(int32_t r) {
+    return Fixed{r};
+  }
+
+  /*
+   *Converts a whole number (e.g. encoder ticks) with no rounding
+   */
+  static constexpr Fixed fromInt(long v) {
+    return Fixed{(int32_t) (v * ONE)};
+  }
+
+  /*
+   *returns: true if v * ONE fits the raw integer, so a division by it can
+   *stay in 32 bits
+   */
+  static constexpr bool shiftFits(long v) {
+    return v > -((long) 1 << (31 - FRAC_BITS)) &&
+           v < ((long) 1 << (31 - FRAC_BITS));
+  }
+
+  /*
+   *Exact-as-possible num/den, rounded down. Used for compile-time constants
+   *(WIDE_FACTOR = 9/5) and for averages (total / count) in one division
+   */
+  static constexpr Fixed fromRatio(long num, long den) {
+    return Fixed{(shiftFits(num) && den == (int32_t) den)
+                     ? (int32_t) num * ONE / (int32_t) den
+                     : (int32_t) (((int64_t) num << FRAC_BITS) / den)};
+  }
+
+  /*
+   *returns: integer part, rounded to nearest
+   */
+  constexpr long toInt() const {
+    return (long) ((raw + (ONE >> 1)) >> FRAC_BITS);
+  }
+
+  constexpr Fixed operator-() const { return Fixed{-raw}; }
+  constexpr Fixed operator+(Fixed o) const { return Fixed{raw + o.raw}; }
+  constexpr Fixed operator-(Fixed o) const { return Fixed{raw - o.raw}; }
+
+  /*
+   *Product rounded to nearest
+   */
+  constexpr Fixed operator*(Fixed o) const {
+    return Fixed{(int32_t) (((int64_t) raw * o.raw + (ONE >> 1)) >> FRAC_BITS)};
+  }
+
+  /*
+   *Quotient of two fixed values, rounded down
+   */
+  constexpr Fixed operator/(Fixed o) const {
+    return Fixed{shiftFits(raw)
+                     ? raw * ONE / o.raw
+                     : (int32_t) (((int64_t) raw << FRAC_BITS) / o.raw)};
+  }
+
+  constexpr Fixed operator*(long k) const { return Fixed{(int32_t) (raw * k)}; }
+  constexpr Fixed operator/(long k) const { return Fixed{(int32_t) (raw / k)}; }
+
+  Fixed &operator+=(Fixed o) {
+    raw += o.raw;
+    return *this;
+  }
+
+  Fixed &operator-=(Fixed o) {
+    raw -= o.raw;
+    return *this;
+  }
+
+  constexpr bool operator<(Fixed o) const { return raw < o.raw; }
+  constexpr bool operator>(Fixed o) const { return raw > o.raw; }
+  constexpr bool operator<=(Fixed o) const { return raw <= o.raw; }
+  constexpr bool operator>=(Fixed o) const { return raw >= o.raw; }
+  constexpr bool operator==(Fixed o) const { return raw == o.raw; }
+  constexpr bool operator!=(Fixed o) const { return raw != o.raw; }
+};
+
+//Q-format used for every bar/space width (ticks). 16 fraction bits keeps the
+//N/W decisions identical to the old float maths except on exact ties
+const uint8_t WIDTH_Q = 16;
+typedef Fixed<WIDTH_Q> Width;
+
+#endif
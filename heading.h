@@ -0,0 +1,134 @@
+/*
+ *Heading (yaw) tracking from the 3pi+'s gyro, used to take the robot's
+ *wobble out of the bar widths. When followSlow() steers, the robot crosses
+ *the bars at an angle θ and every width reads 1/cos(θ) too long; multiplying
+ *by cos(θ) undoes it.
+ *
+ *The gyro is integrated the same way as Pololu's TurnSensor example (2^29
+ *units = 45 degrees, configureForTurnSensing() range of 0.07 dps/digit), but
+ *kept as an angle relative to the heading when scanning started, which is
+ *taken to be square to the bars.
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef HEADING_H
+#define HEADING_H
+
+#include <Arduino.h>
+#include <Pololu3piPlus32U4.h>
+#include "fixedpoint.h"
+
+const Width MAX_YAW_RAD = Width::fromRatio(1, 2); // ~29 deg, past this don't trust it
+const uint8_t SKEW_SHIFT = 2; // weight of a skew measurement is 1/2^SKEW_SHIFT
+
+class HeadingTracker {
+ public:
+  /*
+   *Sets up the IMU. Call once from setup(), after Wire.begin()
+   *returns: false if the IMU didn't answer (widths are then left alone)
+   */
+  bool init() {
+    ok = imu.init();
+    if (ok) {
+      imu.enableDefault();
+      imu.configureForTurnSensing();
+    }
+    return ok;
+  }
+
+  /*
+   *Measures the gyro's zero-rate offset. The robot has to sit still
+   */
+  void calibrate() {
+    if (!ok) return;
+    int32_t total = 0;
+    for (uint16_t i = 0; i < 1024; i++) {
+      while (!imu.gyroDataReady()) {
+      }
+      imu.readGyro();
+      total += imu.g.z;
+    }
+    offset = total / 1024;
+  }
+
+  /*
+   *Takes the current heading as square to the bars
+   */
+  void reset() {
+    angle = 0;
+    markAngle = 0;
+    lastUpdate = micros();
+  }
+
+  /*
+   *Integrates any new gyro reading. Call once per sensor sample: the status
+   *poll and the 6-byte read are about 13 bytes of I2C, 0.3 ms at 400 kHz
+   *(1.2 ms at the default 100 kHz, which setup() raises)
+   */
+  void update() {
+    if (!ok || !imu.gyroDataReady()) return;
+    imu.readGyro();
+    int16_t rate = imu.g.z - offset;
+    uint16_t now = micros();
+    uint16_t dt = now - lastUpdate;
+    lastUpdate = now;
+    // (0.07 dps/digit) * (1e-6 s/us) * (2^29 / 45 units/deg)
+    angle += (int64_t) rate * dt * 14680064 / 17578125;
+  }
+
+  /*
+   *Pulls the integrated heading towards an absolute measurement of the skew
+   *against the bars (see edgestreams.h). The gyro is smooth but drifts, the
+   *edge offsets are noisy but don't, so each one only moves it 1/2^SKEW_SHIFT
+   *of the way
+   *skew: measured angle in radians, counterclockwise positive
+   */
+  void observe(Width skew) {
+    if (skew < -MAX_YAW_RAD || skew > MAX_YAW_RAD) return;
+    // radians to turnAngle units: 2^29 / (pi / 4) = 10430.3784 per raw unit,
+    // in 32 bits since |skew.raw| <= 2^15
+    int32_t target = skew.raw * 10430L + skew.raw * 3784L / 10000;
+    angle += (target - angle) >> SKEW_SHIFT;
+  }
+
+  /*
+   *Removes yaw from the width of the element that just ended, using the
+   *heading halfway through it, and starts the next element
+   *ticks: measured width
+   *returns: width square to the bars
+   */
+  long correct(long ticks) {
+    int32_t mid = markAngle / 2 + angle / 2;
+    markAngle = angle;
+    if (!ok) return ticks;
+    return (Width::fromInt(ticks) * cosine(toRadians(mid))).toInt();
+  }
+
+ private:
+  /*
+   *turnAngle units to radians: (pi / 4) / 2^29
+   */
+  static Width toRadians(int32_t a) {
+    return Width::fromRaw((int32_t) (((int64_t) a * 51472) >> 29));
+  }
+
+  /*
+   *cos(x) to 4th order, plenty for the few degrees the follower wobbles by
+   */
+  static Width cosine(Width x) {
+    if (x < -MAX_YAW_RAD || x > MAX_YAW_RAD) return Width::fromInt(1);
+    Width x2 = x * x;
+    return Width::fromInt(1) - x2 / 2 + x2 * x2 / 24;
+  }
+
+  Pololu3piPlus32U4::IMU imu;
+  bool ok = false;
+  int16_t offset = 0;
+  int32_t angle = 0;     // 2^29 = 45 deg, relative to reset()
+  int32_t markAngle = 0; // heading when the current element started
+  uint16_t lastUpdate = 0;
+};
+
+#endif
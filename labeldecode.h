@@ -0,0 +1,727 @@
+/*
+ *Width classification and whole-label decoding. Nothing in here touches the
+ *robot, so the host tools include it too and decode exactly like the firmware.
+ *
+ *While driving, the firmware only makes hard narrow/wide calls for the beeps,
+ *for rejecting a symbol early and for spotting the stop. The label itself is
+ *decoded from the raw element widths once the robot has crossed all of it: a
+ *Viterbi search lines the elements up with symbols (allowing for an element
+ *lost or split on the way), every symbol is scored against every symbol the
+ *policy knows, the start/stop rules decide which symbols are allowed where,
+ *and the gap between the best and second-best fit gives a confidence. One
+ *element read a bit long, or missed altogether, no longer sinks the label.
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef LABELDECODE_H
+#define LABELDECODE_H
+
+#include <stdint.h>
+#include "fixedpoint.h"
+#include "symbology.h"
+
+/*
+ *Fills in the width cutoffs between the symbology's width classes: a 2-class
+ *symbology splits at wideFactor * narrow, more classes split halfway between
+ *whole modules
+ *unit: length of a narrow (1-module) element
+ *wideFactor: narrow/wide cutoff as a multiple of unit
+ *cutoffs: cutoffs[k - 1] separates k-module elements from (k + 1)-module ones
+ */
+template <class Sym>
+void widthCutoffs(Width unit, Width wideFactor,
+                  Width cutoffs[Sym::WIDTH_CLASSES - 1]) {
+  if (Sym::WIDTH_CLASSES == 2) {
+    cutoffs[0] = wideFactor * unit;
+    return;
+  }
+  for (uint8_t k = 1; k < Sym::WIDTH_CLASSES; k++) {
+    cutoffs[k - 1] = unit * (long) k + unit / 2;
+  }
+}
+
+/*
+ *How far past a cutoff an element has to be for narrowCandidates() to trust
+ *its class. It is a fraction of the spacing between neighbouring classes, so
+ *it leaves as much room for a clear call on Code 93's 1-module steps as on
+ *Code 39's narrow/wide
+ *unit: length of a narrow (1-module) element
+ *wideRatio: wide/narrow ratio (only used by 2-class symbologies)
+ *fraction: guard as a fraction of the class spacing
+ */
+template <class Sym>
+Width prefixGuard(Width unit, Width wideRatio, Width fraction) {
+  Width spacing = unit;
+  if (Sym::WIDTH_CLASSES == 2) {
+    Width extra = wideRatio - Width::fromInt(1);
+    spacing = (extra > Width::fromInt(0)) ? unit * extra : Width::fromInt(0);
+  }
+  return spacing * fraction;
+}
+
+/*
+ *Works out the label's narrow width and wide/narrow ratio from the start
+ *pattern
+ *start: measured widths of the start pattern elements
+ *narrowOut: average narrow element
+ *wideRatioOut: average wide over average narrow (left alone if the start
+ *pattern has no wide elements)
+ */
+template <class Sym>
+void startReference(const uint16_t start[Sym::START_ELEMENTS],
+                    Width &narrowOut, Width &wideRatioOut) {
+  long totalNarrow = 0, totalWide = 0;
+  int narrowCnt = 0, wideCnt = 0;
+  for (uint8_t i = 0; i < Sym::START_ELEMENTS; i++) {
+    if (Sym::startWidth(i) == 1) {
+      totalNarrow += start[i];
+      narrowCnt++;
+    } else {
+      totalWide += start[i];
+      wideCnt++;
+    }
+  }
+  if (narrowCnt > 0) narrowOut = Width::fromRatio(totalNarrow, narrowCnt);
+  if (totalNarrow > 0 && wideCnt > 0) {
+    wideRatioOut = Width::fromRatio(totalWide * narrowCnt, totalNarrow * wideCnt);
+  }
+}
+
+/*
+ *Hard width call for one element
+ *returns: width in modules (1 = narrow)
+ */
+template <class Sym>
+uint8_t classifyWidth(Width w, const Width cutoffs[Sym::WIDTH_CLASSES - 1]) {
+  uint8_t modules = 1;
+  while (modules < Sym::WIDTH_CLASSES && w > cutoffs[modules - 1]) {
+    modules++;
+  }
+  return modules;
+}
+
+//Sym::candidates() for every element and width class, worked out at compile
+//time: mask[j * WIDTH_CLASSES + m - 1] = symbols whose element j is m modules
+template <class Sym, class L> struct PrefixTableOf;
+template <class Sym, uint8_t... K>
+struct PrefixTableOf<Sym, IndexList<K...> > {
+  static constexpr typename Sym::Candidates mask[sizeof...(K)] = {
+    Sym::candidates(K / Sym::WIDTH_CLASSES, K % Sym::WIDTH_CLASSES + 1)...
+  };
+};
+template <class Sym, uint8_t... K>
+constexpr typename Sym::Candidates
+    PrefixTableOf<Sym, IndexList<K...> >::mask[sizeof...(K)];
+
+template <class Sym>
+struct PrefixTable
+    : PrefixTableOf<Sym, typename MakeIndexList<Sym::ELEMENTS *
+                                                Sym::WIDTH_CLASSES>::type> {};
+
+/*
+ *Narrows down which symbols a partly scanned symbol can still be, given its
+ *next element. Only clear calls count: an element within guard of a cutoff
+ *keeps the symbols of both width classes, so this never throws out a symbol
+ *the whole-label decoder could still fix up
+ *live: candidates left after elements 0..j-1 (start from ALL_CANDIDATES)
+ *j: element index within the symbol
+ *w: measured width of element j
+ *guard: how far past a cutoff an element has to be to count
+ *returns: candidates left after element j (check with Sym::anyCandidate)
+ */
+template <class Sym>
+typename Sym::Candidates narrowCandidates(
+    typename Sym::Candidates live, uint8_t j, Width w,
+    const Width cutoffs[Sym::WIDTH_CLASSES - 1], Width guard) {
+  uint8_t lo = classifyWidth<Sym>(w - guard, cutoffs);
+  uint8_t hi = classifyWidth<Sym>(w + guard, cutoffs);
+  typename Sym::Candidates fits = 0;
+  for (uint8_t m = lo; m <= hi; m++) {
+    fits |= PrefixTable<Sym>::mask[j * Sym::WIDTH_CLASSES + m - 1];
+  }
+  return live & fits;
+}
+
+/*
+ *Expected width of an element, in narrow widths
+ *modules: width class of the element
+ *wideRatio: wide/narrow ratio of the label (2-class symbologies only)
+ */
+template <class Sym>
+Width expectedWidth(uint8_t modules, Width wideRatio) {
+  if (modules == 1) return Width::fromInt(1);
+  return (Sym::WIDTH_CLASSES == 2) ? wideRatio : Width::fromInt(modules);
+}
+
+/*
+ *Width of a whole symbol in narrow widths. Every symbol of a policy has the
+ *same number of wide elements (or modules), so this is the same for all of
+ *them
+ */
+template <class Sym>
+Width symbolModules(Width wideRatio) {
+  return (Sym::WIDTH_CLASSES == 2)
+             ? Width::fromInt(Sym::ELEMENTS - Sym::WIDE_ELEMENTS) +
+                   wideRatio * (long) Sym::WIDE_ELEMENTS
+             : Width::fromInt(Sym::MODULES);
+}
+
+/*
+ *How badly one symbol's measured widths fit symbol r
+ *ticks: measured element widths
+ *level: expected width in ticks of each width class (level[0] = narrow)
+ *returns: summed |measured - expected|, in ticks
+ */
+template <class Sym>
+Width symbolMiss(const uint16_t ticks[Sym::ELEMENTS], uint8_t r,
+                 const Width level[Sym::WIDTH_CLASSES]) {
+  uint8_t m[Sym::ELEMENTS];
+  Sym::symbolWidths(r, m);
+
+  Width miss = Width::fromInt(0);
+  for (uint8_t j = 0; j < Sym::ELEMENTS; j++) {
+    Width d = Width::fromInt(ticks[j]) - level[m[j] - 1];
+    miss += (d < Width::fromInt(0)) ? -d : d;
+  }
+  return miss;
+}
+
+//Best fits for one symbol of the label. Costs are the summed misfit as a
+//fraction of the symbol's total width (0 = perfect fit, 2 = nothing in common)
+struct SymbolScore {
+  uint8_t best;     // best-fitting symbol other than the stop
+  Width bestCost;
+  Width secondCost; // runner-up other than the stop
+  Width stopCost;   // fit of the stop symbol (if the policy has one)
+};
+
+/*
+ *Scores one symbol's widths against every symbol of the policy. The measured
+ *total is spread over the symbol's modules, so a symbol read uniformly long or
+ *short (robot speeding up or slowing down) still fits perfectly. Only one
+ *division per call: the per-candidate work is adds and compares, so this is
+ *cheap enough to run between symbols while driving
+ */
+template <class Sym>
+void scoreSymbol(const uint16_t ticks[Sym::ELEMENTS], Width wideRatio,
+                 SymbolScore &out) {
+  long total = 0;
+  for (uint8_t j = 0; j < Sym::ELEMENTS; j++) total += ticks[j];
+
+  out.best = NO_SYMBOL;
+  out.bestCost = out.secondCost = out.stopCost = Width::fromInt(2);
+  if (total == 0) return;
+
+  Width unit = Width::fromInt(total) / symbolModules<Sym>(wideRatio);
+  Width level[Sym::WIDTH_CLASSES];
+  for (uint8_t c = 0; c < Sym::WIDTH_CLASSES; c++) {
+    level[c] = expectedWidth<Sym>(c + 1, wideRatio) * unit;
+  }
+
+  Width worst = Width::fromInt(2 * total);
+  Width bestMiss = worst, secondMiss = worst, stopMiss = worst;
+  for (uint8_t r = 0; r < Sym::SYMBOLS; r++) {
+    Width miss = symbolMiss<Sym>(ticks, r, level);
+    if (r == Sym::STOP_SYMBOL) {
+      stopMiss = miss;
+    } else if (miss < bestMiss) {
+      secondMiss = bestMiss;
+      bestMiss = miss;
+      out.best = r;
+    } else if (miss < secondMiss) {
+      secondMiss = miss;
+    }
+  }
+  out.bestCost = bestMiss / total;
+  out.secondCost = secondMiss / total;
+  out.stopCost = stopMiss / total;
+}
+
+/*
+ *returns: true if the scored symbol fits the stop better than any data symbol
+ */
+template <class Sym>
+bool looksLikeStop(const SymbolScore &sc) {
+  return Sym::STOP_SYMBOL != NO_SYMBOL && sc.stopCost < sc.bestCost;
+}
+
+/*
+ *Confidence of picking the best fit over the runner-up
+ *returns: 0 (a coin toss) to 100 (perfect fit)
+ */
+inline uint8_t marginConfidence(Width best, Width second) {
+  if (!(best < second)) return 0;
+  return (uint8_t) ((second - best) / second * 100L).toInt();
+}
+
+//LABEL SEARCH
+
+/*
+ *Elements the decoder lines up per symbol: the gap in front of it (if the
+ *symbology has one) and the symbol itself
+ */
+template <class Sym>
+constexpr uint8_t chunkElements() {
+  return Sym::ELEMENTS + (Sym::INTERCHAR_GAP ? 1 : 0);
+}
+
+/*
+ *returns: width class of the last element of symbol r
+ */
+template <class Sym>
+uint8_t lastWidth(uint8_t r) {
+  uint8_t w[Sym::ELEMENTS];
+  Sym::symbolWidths(r, w);
+  return w[Sym::ELEMENTS - 1];
+}
+
+inline Width widthDistance(Width a, Width b) {
+  return (a < b) ? b - a : a - b;
+}
+
+/*
+ *How badly measured elements fit printed ones, for the best of the ways they
+ *can line up: one to one (m == l), one measured element covering three
+ *printed ones (m == l - 2: the middle one was too short to get through the
+ *filter and took both its edges with it), or three measured elements covering
+ *one printed one (m == l + 2: a noise spike split it)
+ *a: measured widths, in ticks
+ *e: expected widths, in ticks
+ *narrow: bit j set if printed element j is narrow (only those can be lost)
+ *firstOnly: a merge has to start at the first printed element
+ *returns: summed |measured - expected| of the best line-up
+ */
+template <class Sym>
+Width alignMiss(const uint16_t a[], uint8_t m, const Width e[], uint8_t l,
+                uint16_t narrow, bool firstOnly) {
+  const int8_t shift = (int8_t) m - (int8_t) l;
+  // tail[j]: printed j..l-1 against the measured elements past the merge or
+  // split (so shifted by it)
+  Width tail[chunkElements<Sym>() + 2];
+  tail[l] = Width::fromInt(0);
+  for (int8_t j = l - 1; j >= 0; j--) {
+    tail[j] = tail[j + 1];
+    if (j + shift >= 0) {
+      tail[j] += widthDistance(Width::fromInt(a[j + shift]), e[j]);
+    }
+  }
+  if (shift == 0) return tail[0];
+
+  Width best = Width::fromRaw(0x7FFFFFFF);
+  Width head = Width::fromInt(0); // printed 0..q-1 lined up one to one
+  for (uint8_t q = 0; q < l; q++) {
+    Width miss;
+    if (shift < 0) {
+      if (q + 3 > l || (firstOnly && q > 0)) break;
+      miss = (narrow >> (q + 1) & 1)
+                 ? head + tail[q + 3] +
+                       widthDistance(Width::fromInt(a[q]),
+                                     e[q] + e[q + 1] + e[q + 2])
+                 : best;
+    } else {
+      miss = head + tail[q + 1] +
+             widthDistance(Width::fromInt((long) a[q] + a[q + 1] + a[q + 2]),
+                           e[q]);
+    }
+    if (miss < best) best = miss;
+    head += widthDistance(Width::fromInt(a[q]), e[q]);
+  }
+  return best;
+}
+
+//Best fits of one stretch of the stream, read as one chunk (gap and symbol)
+struct ChunkScore {
+  uint8_t best;     // best-fitting symbol other than the stop
+  Width bestMiss;
+  Width secondMiss; // runner-up other than the stop
+  Width stopMiss;   // fit of the stop symbol (if the policy has one)
+  long total;       // measured ticks the misses are out of
+};
+
+/*
+ *Scores m measured elements as one chunk against every symbol of the policy.
+ *Like scoreSymbol(), the measured total is spread over the chunk's modules;
+ *the gap is expected to be narrow
+ *a: measured widths, in ticks
+ *owed: 0, or the width class of the previous chunk's last element when that
+ *element and this chunk's first two were read as one (a[0])
+ *keepLast: false if this chunk's last element was read together with the
+ *next chunk's first two (see owed)
+ */
+template <class Sym>
+void scoreChunk(const uint16_t a[], uint8_t m, uint8_t owed, bool keepLast,
+                Width wideRatio, ChunkScore &out) {
+  const uint8_t C = Sym::WIDTH_CLASSES;
+  const bool in = owed > 0;
+
+  long total = 0;
+  for (uint8_t j = 0; j < m; j++) total += a[j];
+  out.best = NO_SYMBOL;
+  out.bestMiss = out.secondMiss = out.stopMiss = Width::fromRaw(0x7FFFFFFF);
+  out.total = total;
+  if (total <= 0) return;
+
+  // Expected width of each class, in ticks. Leaving the last element to the
+  // next chunk changes the modules the total is spread over, so there is one
+  // set per class that last element can have
+  Width modules = symbolModules<Sym>(wideRatio) +
+                  Width::fromInt(Sym::INTERCHAR_GAP ? 1 : 0);
+  if (in) modules += expectedWidth<Sym>(owed, wideRatio);
+  Width level[C][C];
+  for (uint8_t v = 0; v < (keepLast ? 1 : C); v++) {
+    Width unit = Width::fromInt(total) /
+                 (keepLast ? modules
+                           : modules - expectedWidth<Sym>(v + 1, wideRatio));
+    for (uint8_t c = 0; c < C; c++) {
+      level[v][c] = expectedWidth<Sym>(c + 1, wideRatio) * unit;
+    }
+  }
+
+  for (uint8_t r = 0; r < Sym::SYMBOLS; r++) {
+    uint8_t w[Sym::ELEMENTS];
+    Sym::symbolWidths(r, w);
+    const Width *lv = level[keepLast ? 0 : w[Sym::ELEMENTS - 1] - 1];
+    Width e[chunkElements<Sym>() + 1];
+    uint16_t narrow = 0;
+    uint8_t l = 0;
+    if (in) {
+      narrow |= (uint16_t) (owed == 1) << l;
+      e[l++] = lv[owed - 1];
+    }
+    if (Sym::INTERCHAR_GAP) {
+      narrow |= (uint16_t) 1 << l;
+      e[l++] = lv[0];
+    }
+    for (uint8_t j = 0; j < Sym::ELEMENTS - (keepLast ? 0 : 1); j++) {
+      narrow |= (uint16_t) (w[j] == 1) << l;
+      e[l++] = lv[w[j] - 1];
+    }
+
+    Width miss = alignMiss<Sym>(a, m, e, l, narrow, in);
+    if (r == Sym::STOP_SYMBOL) {
+      out.stopMiss = miss;
+    } else if (miss < out.bestMiss) {
+      out.secondMiss = out.bestMiss;
+      out.bestMiss = miss;
+      out.best = r;
+    } else if (miss < out.secondMiss) {
+      out.secondMiss = miss;
+    }
+  }
+}
+
+/*
+ *One pass of the label search (see decodeLabel()), with the symbol boundaries
+ *allowed at most slip elements from where the edge count puts them
+ */
+template <class Sym, uint8_t MAX_SYMBOLS, uint8_t MAX_SLIP>
+uint8_t searchLabel(const uint16_t stream[], uint8_t n, Width wideRatio,
+                    Width maxCost, Width slipCost, uint8_t slip, char out[],
+                    uint8_t &len) {
+  const bool hasStop = Sym::STOP_SYMBOL != NO_SYMBOL;
+  const uint8_t P = chunkElements<Sym>();
+  // State at a symbol boundary: offset d from k * P, and whether the element
+  // there is shared with the symbol before it. Index (d + MAX_SLIP) * 2 + owe
+  const uint8_t STATES = (2 * MAX_SLIP + 1) * 2;
+  const Width NONE = Width::fromRaw(0x7FFFFFFF);
+
+  Width cost[2][STATES];
+  uint8_t backState[MAX_SYMBOLS + 1][STATES]; // state at the boundary before
+  uint8_t backSym[MAX_SYMBOLS + 1][STATES];   // symbol between the two
+  for (uint8_t st = 0; st < STATES; st++) cost[0][st] = NONE;
+  cost[0][MAX_SLIP * 2] = Width::fromInt(0);
+
+  Width endCost = NONE;
+  uint8_t endK = 0, endState = 0, endSym = NO_SYMBOL;
+  for (uint8_t k = 0; k < MAX_SYMBOLS; k++) {
+    Width *cur = cost[k & 1], *next = cost[(k + 1) & 1];
+    for (uint8_t st = 0; st < STATES; st++) next[st] = NONE;
+
+    for (uint8_t st = 0; st < STATES; st++) {
+      if (cur[st] == NONE) continue;
+      int8_t d = (int8_t) (st / 2) - MAX_SLIP;
+      bool in = st & 1;
+      int16_t s = (int16_t) k * P + d;
+      uint8_t owed = in ? lastWidth<Sym>(backSym[k][st]) : 0;
+
+      for (uint8_t keep = 0; keep <= 1; keep++) {
+        uint8_t l = P + in - (1 - keep);
+        for (int8_t shift = -2; shift <= 2; shift += 2) {
+          if (in && shift != -2) continue; // a shared element is the slip
+          int16_t m = l + shift;
+          int8_t d2 = d + m - P;
+          if (s + m > n || d2 < -(int8_t) slip || d2 > (int8_t) slip) continue;
+
+          ChunkScore sc;
+          scoreChunk<Sym>(stream + s, (uint8_t) m, owed, keep, wideRatio, sc);
+          if (sc.total <= 0) continue;
+          Width base = cur[st];
+          if (in || shift != 0) base += slipCost;
+          bool ends = keep && s + m == n;
+
+          // The stop (or, without one, any symbol) may end the label
+          Width endMiss = hasStop ? sc.stopMiss : sc.bestMiss;
+          if (ends && endMiss / sc.total <= maxCost &&
+              base + endMiss / sc.total < endCost) {
+            endCost = base + endMiss / sc.total;
+            endK = k + 1;
+            endState = st;
+            endSym = hasStop ? (uint8_t) Sym::STOP_SYMBOL : sc.best;
+          }
+          if (sc.best == NO_SYMBOL || sc.bestMiss / sc.total > maxCost) {
+            continue;
+          }
+          uint8_t st2 = (uint8_t) ((d2 + MAX_SLIP) * 2 + (1 - keep));
+          Width c = base + sc.bestMiss / sc.total;
+          if (c < next[st2]) {
+            next[st2] = c;
+            backState[k + 1][st2] = st;
+            backSym[k + 1][st2] = sc.best;
+          }
+        }
+      }
+    }
+  }
+  len = 0;
+  out[0] = '\0';
+  if (endSym == NO_SYMBOL) return 0;
+
+  // Walk the best path back, then read it forwards
+  uint8_t path[MAX_SYMBOLS], states[MAX_SYMBOLS];
+  path[endK - 1] = endSym;
+  states[endK - 1] = endState;
+  for (uint8_t k = endK - 1; k > 0; k--) {
+    path[k - 1] = backSym[k][states[k]];
+    states[k - 1] = backState[k][states[k]];
+  }
+
+  uint8_t confidence = 100;
+  for (uint8_t k = 0; k < endK; k++) {
+    int16_t s = (int16_t) k * P + states[k] / 2 - MAX_SLIP;
+    int16_t e = (k + 1 < endK) ? (int16_t) (k + 1) * P + states[k + 1] / 2 -
+                                     MAX_SLIP
+                               : n;
+    bool keep = (k + 1 == endK) || !(states[k + 1] & 1);
+    uint8_t owed = (states[k] & 1) ? lastWidth<Sym>(path[k - 1]) : 0;
+    ChunkScore sc;
+    scoreChunk<Sym>(stream + s, (uint8_t) (e - s), owed, keep, wideRatio, sc);
+
+    uint8_t c;
+    if (path[k] == Sym::STOP_SYMBOL) {
+      c = marginConfidence(sc.stopMiss, sc.bestMiss);
+    } else {
+      c = marginConfidence(sc.bestMiss, sc.secondMiss);
+      len += Sym::symbolChars(path[k], out + len);
+    }
+    // A lost element takes its information with it, and the runner-up may
+    // just as well have lost a different one: such a symbol needs twice the
+    // margin (a split one doesn't, its three parts add up to the element)
+    if (e - s < P || owed || !keep) c /= 2;
+    if (c < confidence) confidence = c;
+  }
+  out[len] = '\0';
+
+  if (!Sym::checksum(out, len)) return 0;
+  return confidence;
+}
+
+/*
+ *Decodes a whole label from its raw element widths with a Viterbi search over
+ *where each symbol starts. A boundary normally sits every chunkElements()
+ *elements, but an element too short to see merges with its two neighbours
+ *and a noise spike splits one in three, which moves every later boundary by
+ *two. So the search keeps, for each possible offset of the boundary (and
+ *whether the element on it is shared by the two symbols, which is what a
+ *lost gap looks like), the cheapest way of reading the label up to there.
+ *Each symbol costs its misfit (as in scoreSymbol()) plus slipCost if it
+ *needed a merge or split, the stop is forced onto the last symbol and kept
+ *off every other one, and the policy's checksum then has to hold for the
+ *string as a whole. The straight line-up is tried first. The slips are only
+ *searched if the element count doesn't line up straight, which is what a
+ *lost or split element leaves behind: a label that lines up but doesn't read
+ *has a misprinted symbol, and a merge in one symbol and a split in another
+ *could otherwise explain it away
+ *MAX_SYMBOLS: most symbols a label can have, including the stop
+ *MAX_SLIP: furthest a boundary may drift, in elements
+ *stream: every element after the start pattern, gaps included, in scan order
+ *n: elements in stream (the stop symbol is the last one, if the policy has
+ *one; a stop pattern is not included)
+ *wideRatio: wide/narrow ratio measured on the start pattern
+ *maxCost: worst misfit (fraction of the symbol's width) a symbol may have
+ *and still count as read (a single wrong-class element stays under it; the
+ *LiveAligner is what turns a misprinted symbol into Bad Code)
+ *slipCost: cost of reading a symbol with a merged or split element
+ *out: decoded characters, check characters stripped (room for
+ *MAX_SYMBOLS * CHARS_PER_SYMBOL + 1)
+ *len: number of decoded characters
+ *returns: confidence 0-100 in the string (the smallest best-vs-runner-up
+ *margin of its symbols, halved for one that lost an element), 0 if it isn't
+ *a valid label
+ */
+template <class Sym, uint8_t MAX_SYMBOLS, uint8_t MAX_SLIP>
+uint8_t decodeLabel(const uint16_t stream[], uint8_t n, Width wideRatio,
+                    Width maxCost, Width slipCost, char out[], uint8_t &len) {
+  uint8_t c = searchLabel<Sym, MAX_SYMBOLS, MAX_SLIP>(
+      stream, n, wideRatio, maxCost, slipCost, 0, out, len);
+  if (c == 0 && MAX_SLIP > 0 && n % chunkElements<Sym>() != 0) {
+    c = searchLabel<Sym, MAX_SYMBOLS, MAX_SLIP>(stream, n, wideRatio, maxCost,
+                                                slipCost, MAX_SLIP, out, len);
+  }
+  return c;
+}
+
+//LIVE ALIGNMENT
+
+//What LiveAligner made of the newest element
+enum LiveEvent { LIVE_MORE, LIVE_SYMBOL, LIVE_BAD };
+
+/*
+ *Follows the stream while it is being scanned: cuts it into symbols and
+ *rejects a symbol as soon as no symbol starts like it (narrowCandidates()).
+ *A lost or split element would get every later symbol rejected that way, so
+ *a rejected symbol doesn't end the scan straight away: the next symbol is
+ *checked at every offset up to MAX_SLIP elements from where it should start.
+ *If it still fits where it should, the rejected one was misprinted (Bad
+ *Code); if it only fits somewhere else, an element was lost or split and
+ *scanning carries on from there (decodeLabel() works out exactly where). If
+ *it fits nowhere (the slip was right on the boundary) the one after gets the
+ *same check
+ */
+template <class Sym, uint8_t MAX_SLIP>
+class LiveAligner {
+ public:
+  /*
+   *cutoffs: width cutoffs from widthCutoffs()
+   *guard: elements this close to a cutoff don't count for rejection
+   */
+  void begin(const Width cutoffs[Sym::WIDTH_CLASSES - 1], Width guard) {
+    for (uint8_t k = 0; k + 1 < Sym::WIDTH_CLASSES; k++) cut[k] = cutoffs[k];
+    this->guard = guard;
+    start = 0;
+    drift = 0;
+    probes = 0;
+    live = Sym::ALL_CANDIDATES;
+  }
+
+  /*
+   *Checks the newest element of the stream
+   *stream: every element after the start pattern; n: how many so far
+   *returns: LIVE_SYMBOL when a symbol has been read (it starts at
+   *symbolStart()), LIVE_BAD once the label can't be read, else LIVE_MORE
+   */
+  LiveEvent see(const uint16_t stream[], uint8_t n) {
+    if (probes == 0) return follow(stream, n);
+
+    for (uint8_t o = 0; o <= 2 * MAX_SLIP; o++) {
+      int16_t j = (int16_t) n - 1 - (base + o - MAX_SLIP) - GAP;
+      if (j >= 0 && j < Sym::ELEMENTS) {
+        probe[o] = narrowCandidates<Sym>(probe[o], (uint8_t) j,
+                                         Width::fromInt(stream[n - 1]), cut,
+                                         guard);
+      }
+    }
+    if (n < base + MAX_SLIP + P) return LIVE_MORE;
+
+    // Every window is in: pick the fitting offset closest to where it should
+    // be, a lost element (earlier) before a split one
+    int8_t pick = 0;
+    bool found = false;
+    for (uint8_t k = 0; k <= 2 * MAX_SLIP && !found; k++) {
+      int8_t o = (int8_t) ((k + 1) / 2); // 0, -1, +1, -2, +2...
+      if (k % 2 == 1) o = -o;
+      if (Sym::anyCandidate(probe[o + MAX_SLIP])) {
+        pick = o;
+        found = true;
+      }
+    }
+    if (!found) {
+      if (probes == 2) return LIVE_BAD;
+      startProbe(base + P);
+      return LIVE_MORE;
+    }
+    if (pick == 0 && probes == 1) return LIVE_BAD; // misprinted, not slipped
+    drift += pick;
+    if (drift < -(int8_t) MAX_SLIP || drift > (int8_t) MAX_SLIP) {
+      return LIVE_BAD;
+    }
+
+    // Carry on from the symbol that fitted, catching up on the elements
+    // already read past it
+    read = (uint8_t) (base + pick);
+    start = read + P;
+    probes = 0;
+    live = Sym::ALL_CANDIDATES;
+    for (uint8_t i = start; i < n; i++) check(stream, i);
+    if (!Sym::anyCandidate(live)) startProbe(start + P);
+    return LIVE_SYMBOL;
+  }
+
+  /*
+   *Settles a probe the label ended in the middle of: the windows past the
+   *last element can't be checked, but the one where the symbol should start
+   *can (unless the label ended before it either)
+   *n: elements in the stream
+   *returns: LIVE_BAD if the symbol after the rejected one fits where it
+   *should, so the rejected one was misprinted, else LIVE_MORE
+   */
+  LiveEvent finish(uint8_t n) const {
+    if (probes != 1 || n < base + P) return LIVE_MORE;
+    return Sym::anyCandidate(probe[MAX_SLIP]) ? LIVE_BAD : LIVE_MORE;
+  }
+
+  /*
+   *returns: first element of the symbol last reported, past its gap
+   */
+  uint8_t symbolStart() const {
+    return read + GAP;
+  }
+
+ private:
+  static const uint8_t P = chunkElements<Sym>();
+  static const uint8_t GAP = Sym::INTERCHAR_GAP ? 1 : 0;
+
+  /*
+   *Narrows the current symbol's candidates down by stream[i]
+   */
+  void check(const uint16_t stream[], uint8_t i) {
+    if (i < start + GAP) return; // the gap isn't part of the symbol
+    live = narrowCandidates<Sym>(live, i - start - GAP,
+                                 Width::fromInt(stream[i]), cut, guard);
+  }
+
+  LiveEvent follow(const uint16_t stream[], uint8_t n) {
+    check(stream, n - 1);
+    if (!Sym::anyCandidate(live)) {
+      startProbe(start + P);
+      return LIVE_MORE;
+    }
+    if (n < start + P) return LIVE_MORE;
+    read = start;
+    start += P;
+    live = Sym::ALL_CANDIDATES;
+    return LIVE_SYMBOL;
+  }
+
+  /*
+   *Checks the symbol that should start at from at every offset
+   */
+  void startProbe(uint8_t from) {
+    base = from;
+    probes++;
+    for (uint8_t o = 0; o <= 2 * MAX_SLIP; o++) probe[o] = Sym::ALL_CANDIDATES;
+  }
+
+  Width cut[Sym::WIDTH_CLASSES - 1];
+  Width guard;
+  uint8_t start;  // first element (gap) of the symbol being read
+  uint8_t read;   // first element (gap) of the symbol last reported
+  uint8_t base;   // where the probed symbol should start
+  int8_t drift;   // total offset taken so far
+  uint8_t probes; // 0 = not probing, else which probe
+  typename Sym::Candidates live;
+  typename Sym::Candidates probe[2 * MAX_SLIP + 1]; // by offset + MAX_SLIP
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ *Text layer over the OLED for updating the screen while the robot is scanning.
+ *Every OLED write goes out over the display bus straight away, so printing a
+ *whole line (or clearing the screen) in the middle of a label stalls the
+ *sensor sampling. This keeps a copy of the 21x8 text screen in RAM and only
+ *marks the cells that actually changed; service() is called once per sensor
+ *sample and sends at most GLYPHS_PER_TICK of them, so the most a sample can be
+ *delayed by is one glyph (6 bytes of pixels plus the cursor move).
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef LIVEDISPLAY_H
+#define LIVEDISPLAY_H
+
+#include <Arduino.h>
+#include <Pololu3piPlus32U4.h>
+
+const uint8_t SCREEN_COLS = 21; // setLayout21x8()
+const uint8_t SCREEN_ROWS = 8;
+const uint8_t GLYPHS_PER_TICK = 1;
+
+class LiveDisplay {
+ public:
+  explicit LiveDisplay(Pololu3piPlus32U4::OLED &oled) : oled(oled) { reset(); }
+
+  /*
+   *Call right after clearing the OLED directly: the screen is blank and
+   *nothing is waiting to be sent
+   */
+  void reset() {
+    memset(cells, ' ', sizeof(cells));
+    memset(dirty, 0, sizeof(dirty));
+    pending = 0;
+    next = 0;
+    cx = cy = 0;
+  }
+
+  void gotoXY(uint8_t x, uint8_t y) {
+    cx = x;
+    cy = y;
+  }
+
+  /*
+   *Queues one character at the cursor (nothing is sent if the cell already
+   *shows it)
+   */
+  void print(char c) {
+    if (cx >= SCREEN_COLS || cy >= SCREEN_ROWS) return;
+    if (cells[cy][cx] != c) {
+      cells[cy][cx] = c;
+      uint8_t i = cy * SCREEN_COLS + cx;
+      if (!(dirty[i >> 3] & (1 << (i & 7)))) {
+        dirty[i >> 3] |= 1 << (i & 7);
+        pending++;
+      }
+    }
+    cx++;
+  }
+
+  void print(const char *s) {
+    while (*s) print(*s++);
+  }
+
+  /*
+   *Sends up to maxGlyphs changed cells to the OLED
+   *returns: true if the OLED is now up to date
+   */
+  bool service(uint8_t maxGlyphs = GLYPHS_PER_TICK) {
+    while (pending > 0 && maxGlyphs > 0) {
+      // Round-robin from where the last flush stopped
+      while (!(dirty[next >> 3] & (1 << (next & 7)))) {
+        next = (next + 1 < SCREEN_COLS * SCREEN_ROWS) ? next + 1 : 0;
+      }
+      dirty[next >> 3] &= ~(1 << (next & 7));
+      pending--;
+      maxGlyphs--;
+      uint8_t y = next / SCREEN_COLS, x = next % SCREEN_COLS;
+      oled.gotoXY(x, y);
+      oled.write(cells[y][x]);
+    }
+    return pending == 0;
+  }
+
+  /*
+   *Sends everything still queued (blocking)
+   */
+  void flushAll() {
+    service(SCREEN_COLS * SCREEN_ROWS);
+  }
+
+ private:
+  Pololu3piPlus32U4::OLED &oled;
+  char cells[SCREEN_ROWS][SCREEN_COLS];
+  uint8_t dirty[(SCREEN_ROWS * SCREEN_COLS + 7) / 8];
+  uint8_t pending; // number of dirty cells
+  uint8_t next;    // cell the next flush starts looking from
+  uint8_t cx, cy;
+};
+
+#endif
@@ -2,14 +2,25 @@
  *Moves the Pololu 3pi+ robot across a barcode, translating it from code39 to a
  *string, and returning an error message if the barcode is faulty.
  *
+ *Build with -DSYMBOLOGY=Code93Symbology or -DSYMBOLOGY=Interleaved25Symbology
+ *to read those labels instead (see symbology.h).
+ *
  *Author: OCdt Flood & OCdt Lee
  *Version: 12-11-2025
  */
 
 
 #include <Arduino.h>
+#include <Wire.h>
 #include <Pololu3piPlus32U4.h>
-#include "code39.h"
+#include "fixedpoint.h"
+#include "params.h"
+#include "symbology.h"
+#include "labeldecode.h"
+#include "memstats.h"
+#include "livedisplay.h"
+#include "heading.h"
+#include "edgestreams.h"
 
 using namespace Pololu3piPlus32U4;
 
@@ -17,36 +28,42 @@ using namespace Pololu3piPlus32U4;
 Buzzer buzzer;
 ButtonB buttonB;
 OLED display;
+LiveDisplay live(display); //for updates while scanning
 Motors motors;
 LineSensors lineSensors;
 Encoders encoders;
+HeadingTracker heading; //gyro yaw, to straighten out widths
+OuterEdges edges; //left & right outer sensor edges
 
 
 const uint8_t MAX_CODES = 8; //max amount of chars including delimiters
-const uint8_t MAX_DATA_CHARS = 6; //max amount of chars excluding delimiters
 
 //Off End check on center sensors (calibrated values)
 const uint16_t CENTER_WHITE_LIMIT = 100; //if center sensors < this => white
-//Outer “black” threshold (uncalibrated brightness varies; use a modest bar)
-const uint16_t BLACK_EDGE_MIN = 300; //both outers > NOIR => treat as BLACK
-
-//Start-delimiter normalization
-const float WIDE_FACTOR = 1.8f; //threshold = WIDE_FACTOR * lengthNarrow
-
-//Follower speeds (slow & steady during scanning)
-const int16_t FWD_L_SLOW = 35;
-const int16_t FWD_R_SLOW = 35;
-const int16_t TURN_L_SLOW = 20;
-const int16_t TURN_R_SLOW = 45;
-
-//Inter-character gap stuff
-const uint8_t WHITE_DWELL_MS = 7; //dwell in white before next char
-const uint8_t EDGE_DEBOUNCE_MS = 3; //confirm edge
-const long MIN_TICKS = 5; //ignore microscopic encoder blips
+//Outer sensor span, from the 3pi+ 32U4 (Standard Edition) geometry: the
+//encoders count 12 per motor turn through a 29.86:1 gearbox, 358.3 per turn
+//of a 32 mm wheel, so 358.3 / (pi * 32 mm) = 3.564 ticks/mm. s[0] and s[4]
+//are 4 sensor pitches apart: 4 * 8 mm * 3.564 = 114 ticks. A ruler across
+//s[0] and s[4] should read 32 mm; if not, fix SENSOR_PITCH_MM
+const long TICKS_PER_METRE = 3564;
+const long SENSOR_PITCH_MM = 8; //centre to centre of neighbouring line sensors
+const long OUTER_SENSOR_SPAN_TICKS =
+    (4 * SENSOR_PITCH_MM * TICKS_PER_METRE + 500) / 1000; //s[0] to s[4]
+
+//Symbology this build reads
+#ifndef SYMBOLOGY
+#define SYMBOLOGY Code39Symbology
+#endif
+typedef SYMBOLOGY Symbology;
+
+//Thresholds, speeds and decoder limits are in params.h (shared with tools/)
 
 // Error codes
 enum ErrorType { NO_ERROR, ERR_BAD_CODE, ERR_TOO_LONG, ERR_OFF_END };
 
+// Outcome of waiting for the end of a bar
+enum EdgeResult { EDGE_LOST, EDGE_FOUND, EDGE_QUIET };
+
 //UI SECTION
 
 /*
@@ -79,6 +96,28 @@ void readyScreen() {
   display.print(F("Press B to read"));
 }
 
+/*
+ *Prints the RAM report under the result (see memstats.h), all in bytes
+ */
+void memoryReport() {
+  MemStats m;
+  readMemStats(m);
+  display.gotoXY(0, 3);
+  display.print(F("Static:     "));
+  display.print(m.staticBytes);
+  display.gotoXY(0, 4);
+  display.print(F("Heap:       "));
+  display.print(m.heapBytes);
+  display.print('+');
+  display.print(m.heapFree);
+  display.gotoXY(0, 5);
+  display.print(F("Stack peak: "));
+  display.print(m.stackPeak);
+  display.gotoXY(0, 6);
+  display.print(F("Free min:   "));
+  display.print(m.freeMin);
+}
+
 //HELPER FUNCTIONS
 
 /*
@@ -103,73 +142,52 @@ void followSlow(uint16_t s[5]) {
 }
 
 /*
- *Check if outer sensors are detecting black
- *s: sensor readings
-returns: true if detecting black, false if not
+ *Everything that has to keep up with the robot while scanning, done once per
+ *sensor sample: integrate the gyro and send a queued glyph to the screen
  */
-bool outerSensorsOnLine(uint16_t s[5]) {
-  return (s[0] > BLACK_EDGE_MIN) && (s[4] > BLACK_EDGE_MIN);
+void sampleTick() {
+  heading.update();
+  live.service();
 }
 
 
 /*
- *Moves robot until the start of the barcode
- *returns: true if found the barcode start, false if it gets lost
- */
-bool waitForFirstBlack() {
-  uint16_t s[5];
-  while (true) {
-    lineSensors.readCalibrated(s);
-    if (lostLineCenter(s)) return false;
-    followSlow(s);
-    if (outerSensorsOnLine(s)) return true;
-  }
-}
-
-/*
- *Keeps reading a bar until the color swaps from white <-> black (so we know we
- *reached the end of it)
- *startColor: color of the start of the bar; 0=black, 1=white
- *returns: true once color has swapped, false if off the guide line
+ *Keeps following the line until both outer sensors are past the end of the
+ *current element (each sensor's edges are tracked on their own, see
+ *edgestreams.h)
+ *quietTicks: if > 0, give up once the element is longer than this (quiet
+ *zone)
+ *returns: EDGE_FOUND once both sensors have crossed the edge, EDGE_LOST if off
+ *the guide line (or the sensors disagree by more than EDGE_QUEUE edges),
+ *EDGE_QUIET if the element ran past quietTicks
  */
-bool waitEdgeTransition(int &startColor) {
+EdgeResult waitElement(long quietTicks = 0) {
   uint16_t s[5];
   while (true) {
     lineSensors.readCalibrated(s);
-    if (lostLineCenter(s)) return false;
+    if (lostLineCenter(s)) return EDGE_LOST;
     followSlow(s);
-    int nowColor = outerSensorsOnLine(s) ? 0 : 1;
-    if (nowColor != startColor) {
-      // debounce/confirm
-      delay(EDGE_DEBOUNCE_MS);
-      lineSensors.readCalibrated(s);
-      int confirm = outerSensorsOnLine(s) ? 0 : 1;
-      if (confirm != startColor) {
-        startColor = confirm;
-        return true;
-      }
+    sampleTick();
+    // Each outer sensor is filtered on its own, see edgestreams.h
+    long pos = labs(encoders.getCountsLeft());
+    if (!edges.see(s[0], s[4], pos, MIN_TICKS)) return EDGE_LOST;
+    if (edges.ready(pos, MIN_TICKS)) return EDGE_FOUND;
+    if (quietTicks > 0 && edges.travelled(pos) > quietTicks) {
+      return EDGE_QUIET;
     }
   }
 }
 
 /*
- *Converts an array of W (wide) and N (narrow) to a character from code39
- *seq: array of W/N
- *returns: translated character from code39 |OR| '\0' if a character can't be
- *translated
+ *Finishes the element waitElement() found: averages the two sensors' widths
+ *and takes the skew out, using the sensors' edge offset and the gyro together
+ *returns: width of the element square to the bars, in encoder ticks
  */
-char findChar(const char seq[9]) {
-  for (int r = 0; r < 44; ++r) {
-    bool match = true;
-    for (int j = 0; j < 9; ++j) {
-      if (seq[j] != code39[r][j + 1]) {
-        match = false;
-        break;
-      }
-    }
-    if (match) return code39[r][0];
-  }
-  return '\0'; // no match
+long takeElement() {
+  Width skew;
+  long ticks = edges.take(OUTER_SENSOR_SPAN_TICKS, skew);
+  heading.observe(skew);
+  return heading.correct(ticks);
 }
 
 /*
@@ -212,184 +230,164 @@ void calibrateSensors() {
   motors.setSpeeds(0, 0);
   display.clear();
   delay(200);
+  heading.calibrate(); // sitting still now
 }
 
 /*
- *Normalizes length of a narrow bar using the delimiter character
- *lengthNarrowOut: average length of narrow bars in the delimiter
- *returns: true if delimiter has been fully scanned, false if off guide line or
- * doesn't detect a color swap of bars
+ *Normalizes length of a narrow bar using the start pattern (the '*' delimiter
+ *for Code39)
+ *lengthNarrowOut: average length of narrow bars in the start pattern
+ *wideRatioOut: average wide bar over average narrow bar (left alone if the
+ * start pattern has no wide bars)
+ *returns: true if the start pattern has been fully scanned, false if off guide
+ * line or doesn't detect a color swap of bars
  */
-bool measureNarrowFromStar(float &lengthNarrowOut) {
-  // Ensure we're at first BLACK
-  if (!waitForFirstBlack()) return false;
-
-  // Determine starting color on outers (0=BLACK,1=WHITE)
-  uint16_t s[5];
-  lineSensors.readCalibrated(s);
-  int color = outerSensorsOnLine(s) ? 0 : 1;
-
-  // Reset encoder to measure the first segment length
+template <class Sym>
+bool measureNarrowFromStart(Width &lengthNarrowOut, Width &wideRatioOut) {
+  // Both edge streams start out on the white before the label
   encoders.getCountsAndResetLeft();
+  edges.begin(1, 0);
 
-  // Find '*' row once:
-  int starRow = -1;
-  for (int r = 0; r < 44; r++) {
-    if (code39[r][0] == '*') {
-      starRow = r;
-      break;
-    }
-  }
-  if (starRow < 0) {
-    lengthNarrowOut = 10.f;
-    return true;
-  } // fallback
+  // Ensure we're at first BLACK
+  if (waitElement() != EDGE_FOUND) return false;
+  takeElement();
 
-  float totalNarrow = 0.f;
-  int narrowCnt = 0;
+  uint16_t start[Sym::START_ELEMENTS];
 
-  for (int i = 0; i < 9; i++) {
+  for (uint8_t i = 0; i < Sym::START_ELEMENTS; i++) {
     // wait for next color change
-    if (!waitEdgeTransition(color)) return false;
+    if (waitElement() != EDGE_FOUND) return false;
 
     // width of just-finished segment
-    long ticks = encoders.getCountsAndResetLeft();
-    if (ticks < 0) ticks = -ticks;
-
-    // Is this element narrow or wide in the star pattern?
-    char expected = code39[starRow][i + 1]; // columns 1..9 hold N/W
-    if (expected == 'N') {
-      totalNarrow += (float) ticks;
-      narrowCnt++;
-    } else { buzzer.playNote(NOTE_A(5), 30, 10); } // wide = high note (Req 4b)
+    start[i] = (uint16_t) takeElement();
+
+    // wide = high note (Req 4b)
+    if (Sym::startWidth(i) > 1) buzzer.playNote(NOTE_A(5), 30, 10);
   }
 
-  lengthNarrowOut = (narrowCnt > 0) ? (totalNarrow / (float) narrowCnt) : 10.f;
+  startReference<Sym>(start, lengthNarrowOut, wideRatioOut);
   return true;
 }
 
 
 /*
- *Scans one character (after 1st delimiter)
- *letter: translated char after resulting read
- *threshold: threshold length for wide elements
- *returns: 0 if all ok, 1 if bad code error (3-wide), 2 if bad code (no matching
- *char)
- */
-int scanOne(char &letter, float threshold) {
-  uint16_t s[5];
-  // Current color on outers
-  lineSensors.readCalibrated(s);
-  int color = outerSensorsOnLine(s) ? 0 : 1;
-
-  // We will collect 9 elements; encoder resets at each edge
-  encoders.getCountsAndResetLeft();
-
-  char pattern[9];
-  int wideCount = 0;
-
-  for (int i = 0; i < 9; i++) {
-    // Wait until color toggles (edge)
-    if (!waitEdgeTransition(color)) return 0; // OffEnd handled by caller
-
-    long ticks = encoders.getCountsAndResetLeft();
-    if (ticks < 0) ticks = -ticks;
-    if (ticks < MIN_TICKS) {
-      i--;
-      continue;
-    } // ignore flicker
-
-    if ((float) ticks > threshold) {
-      pattern[i] = 'W';
-      wideCount++;
-      buzzer.playNote(NOTE_A(5), 30, 10);
-    } else {
-      pattern[i] = 'N';
-    }
-  }
-
-  letter = findChar(pattern);
-  if (letter == '\0') return 2; // no match
-  // 3-wide rule only for data (not for '*')
-  if (letter != '*' && wideCount != 3) return 1;
-
-  return 0; // OK
-}
-
-/*
- *Actually reads the entire barcode using above functions
- *decoded: array with the decoded string
+ *Actually reads the entire barcode using above functions. Every element after
+ *the start pattern (gaps included) is kept until the stop, then the whole
+ *label is decoded at once (see labeldecode.h)
+ *decoded: array with the decoded string (room for the check chars too)
+ *confidence: how sure the decoder is of decoded, 0-100
  *returns: Enum ErrorType depending on if it encounters an error or not
  */
-ErrorType readBarcode(char decoded[MAX_DATA_CHARS + 1]) {
+template <class Sym>
+ErrorType readBarcode(char decoded[MAX_DATA_CHARS + Sym::CHECK_CHARS + 1],
+                      uint8_t &confidence) {
   decoded[0] = '\0';
-  uint8_t dataLen = 0;
-  uint8_t codeCount = 0; // includes delimiters
-
-  // 0) Normalize using the first '*'
-  float narrowRefLen = 10.f;
-  if (!measureNarrowFromStar(narrowRefLen)) {
+  confidence = 0;
+  const uint8_t maxChars = MAX_DATA_CHARS + Sym::CHECK_CHARS;
+  const uint8_t maxSymbols =
+      (maxChars + Sym::CHARS_PER_SYMBOL - 1) / Sym::CHARS_PER_SYMBOL + 1;
+  const uint8_t maxElements =
+      maxSymbols * chunkElements<Sym>() + MAX_SLIP + Sym::STOP_ELEMENTS;
+  uint16_t stream[maxElements];
+  uint8_t n = 0;
+  uint8_t shown = 0; // chars of the best guess on screen so far
+
+  // Clear once before moving; after that only changed glyphs get sent
+  display.clear();
+  live.reset();
+  live.gotoXY(0, 0);
+  live.print("Reading");
+  live.flushAll();
+
+  // Placed on the line square to the bars: yaw is measured from here
+  heading.reset();
+
+  // 0) Normalize using the start pattern
+  Width narrowRefLen = Width::fromInt(10);
+  Width wideRatio = DEFAULT_WIDE_RATIO;
+  if (!measureNarrowFromStart<Sym>(narrowRefLen, wideRatio)) {
     motors.setSpeeds(0, 0);
     return ERR_OFF_END;
   }
-  float wideCutoff = WIDE_FACTOR * narrowRefLen;
-
-  // Dwell helper: ensure white gap, then wait for next black
-  auto waitWhiteThenBlack = [&]()-> bool {
-    uint16_t s[5];
-    // ensure white
-    while (true) {
-      lineSensors.readCalibrated(s);
-      if (lostLineCenter(s)) return false;
-      followSlow(s);
-      if (!outerSensorsOnLine(s)) break;
-    }
-    delay(WHITE_DWELL_MS);
-    // wait until next black
-    return waitForFirstBlack();
-  };
+  Width cutoffs[Sym::WIDTH_CLASSES - 1];
+  widthCutoffs<Sym>(narrowRefLen, WIDE_FACTOR, cutoffs);
+  long quietTicks = (narrowRefLen * QUIET_FACTOR).toInt();
+  LiveAligner<Sym, MAX_SLIP> aligner;
+  aligner.begin(cutoffs,
+                prefixGuard<Sym>(narrowRefLen, wideRatio, PREFIX_GUARD));
 
-  // 1) Now scan characters until ending '*'
+  // Low note = new character (Req 4a)
+  buzzer.playNote(NOTE_C(4), 100, 10);
+
+  // 1) Record elements until the stop (or the quiet zone after the label)
   while (true) {
-    // Safety: Too long? (max 6 data + 1 end delimiter after the first star)
-    if (codeCount >= 7) {
+    // Safety: Too long? (max data + check chars + the stop after the start)
+    if (n == maxElements) {
       motors.setSpeeds(0, 0);
       return ERR_TOO_LONG;
     }
 
-    // Be sure we start each char cleanly
-    if (!waitWhiteThenBlack()) {
+    // Only a white element can turn out to be the quiet zone
+    EdgeResult edge = waitElement((edges.color() == 1) ? quietTicks : 0);
+    if (edge == EDGE_LOST) {
       motors.setSpeeds(0, 0);
       return ERR_OFF_END;
     }
+    if (edge == EDGE_QUIET) break;
 
-    // Low note = new character (Req 4a)
-    buzzer.playNote(NOTE_C(4), 100, 10);
+    long ticks = takeElement();
+    stream[n++] = (uint16_t) ticks;
+    if (classifyWidth<Sym>(Width::fromInt(ticks), cutoffs) > 1) {
+      buzzer.playNote(NOTE_A(5), 30, 10); // wide = high note (Req 4b)
+    }
 
-    char letter = '\0';
-    int err = scanOne(letter, wideCutoff);
-    if (err == 1 || err == 2) {
+    // Give up now rather than at the stop if no symbol starts like this
+    LiveEvent ev = aligner.see(stream, n);
+    if (ev == LIVE_BAD) {
       motors.setSpeeds(0, 0);
       return ERR_BAD_CODE;
     }
+    if (ev != LIVE_SYMBOL) continue;
 
     // End delimiter?
-    if (letter == '*') {
-      motors.setSpeeds(0, 0);
-      return NO_ERROR;
-    }
+    SymbolScore sc;
+    scoreSymbol<Sym>(stream + aligner.symbolStart(), wideRatio, sc);
+    if (looksLikeStop<Sym>(sc)) break;
+    buzzer.playNote(NOTE_C(4), 100, 10);
 
-    // Append data
-    if (dataLen < MAX_DATA_CHARS) {
-      decoded[dataLen++] = letter;
-      decoded[dataLen] = '\0';
-    } else {
-      motors.setSpeeds(0, 0);
-      return ERR_TOO_LONG;
-    }
+    if (sc.best == NO_SYMBOL) continue; // nothing to show yet
 
-    codeCount++;
+    // Best guess so far goes on screen a glyph per sample
+    char letters[Sym::CHARS_PER_SYMBOL];
+    uint8_t k = Sym::symbolChars(sc.best, letters);
+    live.gotoXY(shown, 1);
+    for (uint8_t c = 0; c < k; c++) live.print(letters[c]);
+    shown += k;
+  }
+  motors.setSpeeds(0, 0);
+  if (aligner.finish(n) == LIVE_BAD) return ERR_BAD_CODE;
+
+  // A stop pattern (not a symbol) has to be right before the quiet zone
+  if (Sym::STOP_ELEMENTS > 0) {
+    uint8_t pattern[Sym::STOP_ELEMENTS + 1];
+    if (n < Sym::STOP_ELEMENTS) return ERR_BAD_CODE;
+    n -= Sym::STOP_ELEMENTS;
+    for (uint8_t i = 0; i < Sym::STOP_ELEMENTS; i++) {
+      pattern[i] = classifyWidth<Sym>(Width::fromInt(stream[n + i]), cutoffs);
+    }
+    if (!Sym::isStop(pattern, Sym::STOP_ELEMENTS)) return ERR_BAD_CODE;
   }
+
+  // 2) Decode the whole label
+  char text[maxSymbols * Sym::CHARS_PER_SYMBOL + 1];
+  uint8_t len = 0;
+  confidence = decodeLabel<Sym, maxSymbols, MAX_SLIP>(
+      stream, n, wideRatio, MAX_SYMBOL_COST, SLIP_COST, text, len);
+  if (confidence < MIN_CONFIDENCE) return ERR_BAD_CODE;
+  if (len > MAX_DATA_CHARS) return ERR_TOO_LONG;
+
+  memcpy(decoded, text, len + 1);
+  return NO_ERROR;
 }
 
 //ARDUINO STUFF
@@ -402,6 +400,10 @@ void setup() {
   encoders.getCountsLeft();
   encoders.getCountsRight();
 
+  Wire.begin(); //the IMU is on I2C
+  Wire.setClock(400000); //fast mode, the gyro is read every sample
+  heading.init(); //no IMU => widths just aren't yaw corrected
+
   introScreen();
 }
 
@@ -414,8 +416,9 @@ void loop() {
   readyScreen();
   buttonB.waitForButton();
 
-  char decoded[MAX_DATA_CHARS + 1];
-  ErrorType err = readBarcode(decoded);
+  char decoded[MAX_DATA_CHARS + Symbology::CHECK_CHARS + 1];
+  uint8_t confidence = 0;
+  ErrorType err = readBarcode<Symbology>(decoded, confidence);
 
   // Show result
   display.clear();
@@ -423,7 +426,9 @@ void loop() {
   display.print(decoded); // may be empty (e.g., "**")
   display.gotoXY(0, 1);
   switch (err) {
-    case NO_ERROR: display.print(F("OK"));
+    case NO_ERROR: display.print(F("OK "));
+      display.print(confidence);
+      display.print('%');
       break;
     case ERR_BAD_CODE: display.print(F("Bad Code"));
       break;
@@ -432,6 +437,7 @@ void loop() {
     case ERR_OFF_END: display.print(F("Off End"));
       break;
   }
+  memoryReport();
 
   motors.setSpeeds(0, 0);
   while (true) {
@@ -0,0 +1,108 @@
+/*
+ *SRAM usage instrumentation for the ATmega32U4 (2.5 KB). The stack grows down
+ *from the top of RAM and the heap grows up from the end of .bss; if they ever
+ *meet, something gets silently corrupted. To see how close that is:
+ *
+ *  - at boot (before main() even sets up the stack) every byte between the end
+ *    of .bss and the top of RAM is painted with STACK_CANARY
+ *  - the deepest the stack has ever gone is the first byte from the bottom of
+ *    that region that isn't a canary any more
+ *  - heap use comes straight from malloc's own bookkeeping (__brkval and the
+ *    free list), so mainbutliketheactualone.cpp's BarCharacter nodes and
+ *    anything else that mallocs are counted without wrapping malloc
+ *
+ *Only include this from one .cpp file: it defines the .init1 painting code.
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+const uint8_t STACK_CANARY = 0xC5;
+
+//Linker/avr-libc symbols
+extern uint8_t __data_start; // first byte of .data (start of static RAM)
+extern uint8_t _end;         // first byte after .bss (heap starts here)
+extern uint8_t __stack;      // last byte of RAM
+extern char *__brkval;       // top of the heap (0 until the first malloc)
+
+//Same layout as avr-libc's free list entries (stdlib_private.h)
+struct __freelist {
+  size_t sz;
+  struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+
+/*
+ *Paints [_end, __stack] with STACK_CANARY. Runs in .init1, before the C
+ *runtime sets up r1 and SP, so it is plain assembly and is never called
+ */
+void paintStack() __attribute__((naked, used, section(".init1")));
+void paintStack() {
+  __asm volatile(
+      "    ldi r30, lo8(_end)\n"
+      "    ldi r31, hi8(_end)\n"
+      "    ldi r24, %0\n"
+      "    ldi r25, hi8(__stack)\n"
+      "    rjmp 2f\n"
+      "1:  st Z+, r24\n"
+      "2:  cpi r30, lo8(__stack)\n"
+      "    cpc r31, r25\n"
+      "    brlo 1b\n"
+      "    breq 1b\n"
+      :
+      : "i"(STACK_CANARY));
+}
+
+//Snapshot of where the RAM has gone, all in bytes
+struct MemStats {
+  uint16_t staticBytes; // .data + .bss
+  uint16_t heapBytes;   // heap currently handed out by malloc
+  uint16_t heapFree;    // heap freed but still held on malloc's free list
+  uint16_t stackPeak;   // deepest the stack has ever been
+  uint16_t freeMin;     // smallest the gap between heap top and stack has
+                        // ever been (untouched canaries)
+};
+
+/*
+ *returns: first byte above the heap
+ */
+inline uint8_t *heapTop() {
+  return (__brkval != 0) ? (uint8_t *) __brkval : &_end;
+}
+
+/*
+ *Runtime high-water mark of the stack
+ *returns: lowest address the stack has ever written to
+ */
+inline uint8_t *stackHighWater() {
+  uint8_t *p = heapTop();
+  while (p <= &__stack && *p == STACK_CANARY) p++;
+  return p;
+}
+
+/*
+ *Fills in a MemStats snapshot
+ */
+inline void readMemStats(MemStats &m) {
+  uint8_t *top = heapTop();
+  uint8_t *low = stackHighWater();
+
+  uint16_t onFreeList = 0;
+  for (struct __freelist *f = __flp; f != 0; f = f->nx) {
+    onFreeList += f->sz + sizeof(size_t);
+  }
+
+  m.staticBytes = &_end - &__data_start;
+  m.heapFree = onFreeList;
+  m.heapBytes = (top - &_end) - onFreeList;
+  m.stackPeak = &__stack - low + 1;
+  m.freeMin = low - top;
+}
+
+#endif
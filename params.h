@@ -0,0 +1,67 @@
+/*
+ *Constants shared by the firmware and the host tools (tools/), so the
+ *simulator decodes with exactly what the robot runs.
+ *
+ *The tunable ones come from tuned_params.h when tools/autotune has generated
+ *one next to this file; otherwise the hand-picked defaults below are used.
+ *Delete tuned_params.h to go back to them.
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdint.h>
+#include "fixedpoint.h"
+
+const uint8_t MAX_DATA_CHARS = 6; //max amount of chars excluding delimiters
+
+//Start-delimiter normalization
+const long QUIET_FACTOR = 8; //white > QUIET_FACTOR * narrow => quiet zone
+const Width DEFAULT_WIDE_RATIO = Width::fromRatio(5, 2); //start has no wide bar
+
+//Whole-label decoding
+const uint8_t MIN_CONFIDENCE = 25; //label confidence (%) below this => Bad Code
+const Width MAX_SYMBOL_COST = Width::fromRatio(1, 5); //worse fit => Bad Code
+const Width PREFIX_GUARD = Width::fromRatio(2, 5); //fraction of the class
+                                                   //spacing either side of a
+                                                   //cutoff too close to call
+const uint8_t MAX_SLIP = 2; //elements a lost or split element may shift symbols
+const Width SLIP_COST = Width::fromRatio(1, 10); //cost of a lost/split element
+
+//Narrow/wide cutoff for live prefix rejection (see LiveAligner). Not tuned:
+//the decoder measures the wide ratio on the start pattern, so the read rate
+//doesn't depend on it
+const Width WIDE_FACTOR = Width::fromRatio(9, 5); //threshold = 1.8 * lengthNarrow
+
+//TUNABLE
+
+#if defined(__has_include)
+#if __has_include("tuned_params.h")
+#define HAVE_TUNED_PARAMS
+#endif
+#endif
+
+#ifdef HAVE_TUNED_PARAMS
+#include "tuned_params.h"
+#else
+//Outer “black” threshold, halfway up the calibrated range so the filter lag
+//is the same on both edges of a bar (see SchmittFilter)
+const uint16_t BLACK_EDGE_MIN = 500; //outer > NOIR => that sensor sees BLACK
+
+//Follower speeds (slow & steady during scanning)
+const int16_t FWD_L_SLOW = 35;
+const int16_t FWD_R_SLOW = 35;
+const int16_t TURN_L_SLOW = 20;
+const int16_t TURN_R_SLOW = 45;
+
+//Edge stuff
+const uint8_t FILTER_SHIFT = 1; //outer sensor IIR: level += (s - level) >> this
+const uint16_t EDGE_HYSTERESIS = 100; //black above BLACK_EDGE_MIN + this, white
+                                      //below BLACK_EDGE_MIN - this
+const long MIN_TICKS = 5; //ignore microscopic encoder blips
+#endif
+
+#endif
@@ -0,0 +1,407 @@
+/*
+ *Symbology policies for the barcode reader. Each policy is a struct of
+ *compile-time constants plus a few static functions, and main.cpp's scanning
+ *code is templated on one of them, so the build only contains the symbology it
+ *reads and every table lookup is resolved statically (no virtual calls).
+ *
+ *Element widths are passed around in modules: 1 = narrow, 2 = wide, and for
+ *Code 93 up to 4.
+ *
+ *A policy provides:
+ *  ELEMENTS         bars + spaces per symbol
+ *  WIDTH_CLASSES    how many widths an element can have
+ *  WIDE_ELEMENTS    wide elements in every symbol (2 width classes)
+ *  MODULES          modules in every symbol (more width classes)
+ *  START_ELEMENTS   length of the start pattern (used to measure the narrow)
+ *  CHARS_PER_SYMBOL characters one symbol decodes to
+ *  CHECK_CHARS      trailing check characters included in the data
+ *  INTERCHAR_GAP    true if symbols are separated by a white gap
+ *  STOP_CHAR        decoded character that ends the label ('\0' if none)
+ *  STOP_ELEMENTS    length of a stop pattern followed by the quiet zone
+ *                   (0 if the stop is a normal symbol)
+ *  startWidth(i)    modules of element i of the start pattern
+ *  decode(w, out)   symbol -> characters, returns how many (0 = no match)
+ *  isStop(w, n)     true if the n elements in w are the stop pattern
+ *  stopWidth(i)     modules of element i of that stop pattern
+ *  checksum(s, len) validates and strips the check characters
+ *
+ *and, for the whole-label decoder (labeldecode.h), every symbol it can read:
+ *  SYMBOLS            number of symbols, including the stop
+ *  STOP_SYMBOL        index of the stop symbol (NO_SYMBOL if it has none)
+ *  symbolWidths(r, w) module widths of symbol r
+ *  symbolChars(r, out) characters symbol r decodes to, returns how many
+ *
+ *and, for rejecting a symbol while it is still being scanned, a set of
+ *symbols that a partly read symbol could still be:
+ *  Candidates             integer type holding the set
+ *  ALL_CANDIDATES         every symbol (including the stop)
+ *  candidates(j, m)       constexpr: symbols whose element j is m modules
+ *  anyCandidate(c)        true if c still holds a whole symbol
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef SYMBOLOGY_H
+#define SYMBOLOGY_H
+
+#include <stdint.h>
+#include "code39.h"
+
+//COMPILE-TIME TABLE HELPERS
+
+//List of indices 0..N-1, used to expand a constexpr table one row at a time
+template <uint8_t... I> struct IndexList {};
+template <uint8_t N, uint8_t... I>
+struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...> {};
+template <uint8_t... I>
+struct MakeIndexList<0, I...> {
+  typedef IndexList<I...> type;
+};
+
+//CODE 39
+
+/*
+ *Packs row r of code39 into a 9-bit mask (first element in the top bit,
+ *wide = 1)
+ */
+constexpr uint16_t code39Mask(uint8_t r, uint8_t j = 0) {
+  return j == 9 ? 0
+                : (uint16_t) (((code39[r][j + 1] == 'W') ? 1 : 0) << (8 - j)) |
+                  code39Mask(r, j + 1);
+}
+
+/*
+ *returns: row of character c in code39, or 0xFF if it isn't there
+ */
+constexpr uint8_t code39Row(char c, uint8_t r = 0) {
+  return r == 44 ? 0xFF : (code39[r][0] == c ? r : code39Row(c, r + 1));
+}
+
+const uint8_t NO_SYMBOL = 0xFF;
+
+template <class L> struct Code39Table;
+template <uint8_t... R>
+struct Code39Table<IndexList<R...> > {
+  static constexpr uint16_t mask[sizeof...(R)] = {code39Mask(R)...};
+  static constexpr char letter[sizeof...(R)] = {code39[R][0]...};
+};
+template <uint8_t... R>
+constexpr uint16_t Code39Table<IndexList<R...> >::mask[sizeof...(R)];
+template <uint8_t... R>
+constexpr char Code39Table<IndexList<R...> >::letter[sizeof...(R)];
+
+typedef Code39Table<MakeIndexList<44>::type> Code39Lookup;
+
+/*
+ *Rows of code39 whose element j is m modules wide, one bit per row
+ */
+constexpr uint64_t code39Candidates(uint8_t j, uint8_t m, uint8_t r = 0) {
+  return r == 44 ? 0
+                 : ((((code39Mask(r) >> (8 - j)) & 1) + 1 == m)
+                        ? (uint64_t) 1 << r
+                        : 0) |
+                   code39Candidates(j, m, r + 1);
+}
+
+static_assert(code39Row('*') != 0xFF, "code39 table has no '*' delimiter");
+
+struct Code39Symbology {
+  static const uint8_t ELEMENTS = 9;
+  static const uint8_t WIDTH_CLASSES = 2;
+  static const uint8_t WIDE_ELEMENTS = 3;
+  static const uint8_t MODULES = 0;
+  static const uint8_t START_ELEMENTS = 9;
+  static const uint8_t CHARS_PER_SYMBOL = 1;
+  static const uint8_t CHECK_CHARS = 0;
+  static const bool INTERCHAR_GAP = true;
+  static const char STOP_CHAR = '*';
+  static const uint8_t STOP_ELEMENTS = 0;
+
+  static const uint8_t SYMBOLS = 44;
+  static const uint8_t STOP_SYMBOL = code39Row('*');
+
+  static const uint16_t START_MASK = code39Mask(STOP_SYMBOL);
+
+  typedef uint64_t Candidates;
+  static const Candidates ALL_CANDIDATES = ((uint64_t) 1 << 44) - 1;
+
+  static constexpr Candidates candidates(uint8_t j, uint8_t m) {
+    return code39Candidates(j, m);
+  }
+
+  static bool anyCandidate(Candidates c) { return c != 0; }
+
+  static uint8_t startWidth(uint8_t i) {
+    return ((START_MASK >> (8 - i)) & 1) + 1;
+  }
+
+  static uint8_t decode(const uint8_t w[ELEMENTS], char out[]) {
+    uint16_t mask = 0;
+    for (uint8_t j = 0; j < ELEMENTS; j++) {
+      mask = (mask << 1) | (w[j] > 1);
+    }
+    for (uint8_t r = 0; r < 44; r++) {
+      if (Code39Lookup::mask[r] == mask) {
+        out[0] = Code39Lookup::letter[r];
+        return 1;
+      }
+    }
+    return 0; // no match
+  }
+
+  static uint8_t stopWidth(uint8_t) { return 1; } // no stop pattern
+  static bool isStop(const uint8_t *, uint8_t) { return false; }
+
+  static bool checksum(char *, uint8_t &) { return true; } // no check char
+
+  static void symbolWidths(uint8_t r, uint8_t w[ELEMENTS]) {
+    for (uint8_t j = 0; j < ELEMENTS; j++) {
+      w[j] = ((Code39Lookup::mask[r] >> (8 - j)) & 1) + 1;
+    }
+  }
+
+  static uint8_t symbolChars(uint8_t r, char out[]) {
+    out[0] = Code39Lookup::letter[r];
+    return 1;
+  }
+};
+
+//INTERLEAVED 2 OF 5
+
+/*
+ *Wide positions of each digit's 5 elements (first element in the top bit)
+ */
+constexpr uint8_t i25Wide[10] = {
+  0x06, 0x11, 0x09, 0x18, 0x05, 0x14, 0x0C, 0x03, 0x12, 0x0A
+};
+
+/*
+ *Digits whose element k (of 5) is m modules wide, one bit per digit
+ */
+constexpr uint16_t i25Candidates(uint8_t k, uint8_t m, uint8_t d = 0) {
+  return d == 10 ? 0
+                 : ((((i25Wide[d] >> (4 - k)) & 1) + 1 == m) ? 1 << d : 0) |
+                   i25Candidates(k, m, d + 1);
+}
+
+struct Interleaved25Symbology {
+  static const uint8_t ELEMENTS = 10; // 5 bars (1st digit) + 5 spaces (2nd)
+  static const uint8_t WIDTH_CLASSES = 2;
+  static const uint8_t WIDE_ELEMENTS = 4; // 2 per digit
+  static const uint8_t MODULES = 0;
+  static const uint8_t START_ELEMENTS = 4; // narrow bar/space/bar/space
+  static const uint8_t CHARS_PER_SYMBOL = 2;
+  static const uint8_t CHECK_CHARS = 0;
+  static const bool INTERCHAR_GAP = false;
+  static const char STOP_CHAR = '\0';
+  static const uint8_t STOP_ELEMENTS = 3; // wide bar, narrow space, narrow bar
+
+  static const uint8_t SYMBOLS = 100; // every digit pair, r = 10 * first + second
+  static const uint8_t STOP_SYMBOL = NO_SYMBOL;
+
+  // Bars only pin down the first digit and spaces the second, so the pair is
+  // kept as two 10-bit digit sets: first digit in bits 0-9, second in 10-19
+  typedef uint32_t Candidates;
+  static const Candidates ALL_CANDIDATES = 0xFFFFFUL;
+
+  static constexpr Candidates candidates(uint8_t j, uint8_t m) {
+    return (j % 2 == 0) ? (0xFFC00UL | i25Candidates(j / 2, m))
+                        : (0x003FFUL | (Candidates) i25Candidates(j / 2, m) << 10);
+  }
+
+  static bool anyCandidate(Candidates c) {
+    return (c & 0x003FF) != 0 && (c & 0xFFC00) != 0;
+  }
+
+  static uint8_t startWidth(uint8_t) { return 1; }
+
+  static char digit(uint8_t mask) {
+    for (uint8_t d = 0; d < 10; d++) {
+      if (i25Wide[d] == mask) return (char) ('0' + d);
+    }
+    return '\0';
+  }
+
+  static uint8_t decode(const uint8_t w[ELEMENTS], char out[]) {
+    uint8_t bars = 0, spaces = 0;
+    for (uint8_t j = 0; j < ELEMENTS; j += 2) {
+      bars = (bars << 1) | (w[j] > 1);
+      spaces = (spaces << 1) | (w[j + 1] > 1);
+    }
+    out[0] = digit(bars);
+    out[1] = digit(spaces);
+    return (out[0] != '\0' && out[1] != '\0') ? 2 : 0;
+  }
+
+  static uint8_t stopWidth(uint8_t i) { return (i == 0) ? 2 : 1; }
+
+  static bool isStop(const uint8_t *w, uint8_t n) {
+    if (n != STOP_ELEMENTS) return false;
+    for (uint8_t j = 0; j < n; j++) {
+      if (w[j] != stopWidth(j)) return false;
+    }
+    return true;
+  }
+
+  static bool checksum(char *, uint8_t &) { return true; } // no check digit
+
+  static void symbolWidths(uint8_t r, uint8_t w[ELEMENTS]) {
+    for (uint8_t j = 0; j < 5; j++) {
+      w[2 * j] = ((i25Wide[r / 10] >> (4 - j)) & 1) + 1;
+      w[2 * j + 1] = ((i25Wide[r % 10] >> (4 - j)) & 1) + 1;
+    }
+  }
+
+  static uint8_t symbolChars(uint8_t r, char out[]) {
+    out[0] = (char) ('0' + r / 10);
+    out[1] = (char) ('0' + r % 10);
+    return 2;
+  }
+};
+
+//CODE 93
+
+/*
+ *Packs the six module widths of a Code 93 symbol, 2 bits each (width - 1),
+ *first element in the top bits
+ */
+constexpr uint16_t w93(uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint8_t e,
+                       uint8_t f) {
+  return (uint16_t) ((a - 1) << 10 | (b - 1) << 8 | (c - 1) << 6 |
+                     (d - 1) << 4 | (e - 1) << 2 | (f - 1));
+}
+
+/*
+ *Code 93 characters in value order (the value is what the checksums use).
+ *\x01..\x04 are the ($) (%) (/) (+) full-ASCII shift characters
+ */
+constexpr char code93Chars[] =
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ-. $/+%\x01\x02\x03\x04*";
+
+constexpr uint16_t code93Widths[48] = {
+  w93(1,3,1,1,1,2), w93(1,1,1,2,1,3), w93(1,1,1,3,1,2), w93(1,1,1,4,1,1),
+  w93(1,2,1,1,1,3), w93(1,2,1,2,1,2), w93(1,2,1,3,1,1), w93(1,1,1,1,1,4),
+  w93(1,3,1,2,1,1), w93(1,4,1,1,1,1), w93(2,1,1,1,1,3), w93(2,1,1,2,1,2),
+  w93(2,1,1,3,1,1), w93(2,2,1,1,1,2), w93(2,2,1,2,1,1), w93(2,3,1,1,1,1),
+  w93(1,1,2,1,1,3), w93(1,1,2,2,1,2), w93(1,1,2,3,1,1), w93(1,2,2,1,1,2),
+  w93(1,3,2,1,1,1), w93(1,1,1,1,2,3), w93(1,1,1,2,2,2), w93(1,1,1,3,2,1),
+  w93(1,2,1,1,2,2), w93(1,3,1,1,2,1), w93(2,1,2,1,1,2), w93(2,1,2,2,1,1),
+  w93(2,1,1,1,2,2), w93(2,1,1,2,2,1), w93(2,2,1,1,2,1), w93(2,2,2,1,1,1),
+  w93(1,1,2,1,2,2), w93(1,1,2,2,2,1), w93(1,2,2,1,2,1), w93(1,2,3,1,1,1),
+  w93(1,2,1,1,3,1), w93(3,1,1,1,1,2), w93(3,1,1,2,1,1), w93(3,2,1,1,1,1),
+  w93(1,1,2,1,3,1), w93(1,1,3,1,2,1), w93(2,1,1,1,3,1), w93(1,2,1,2,2,1),
+  w93(3,1,2,1,1,1), w93(3,1,1,1,2,1), w93(1,2,2,2,1,1), w93(1,1,1,1,4,1)
+};
+
+/*
+ *Code 93 symbols whose element j is m modules wide, one bit per symbol
+ */
+constexpr uint64_t code93Candidates(uint8_t j, uint8_t m, uint8_t r = 0) {
+  return r == 48 ? 0
+                 : ((((code93Widths[r] >> (10 - 2 * j)) & 3) + 1 == m)
+                        ? (uint64_t) 1 << r
+                        : 0) |
+                   code93Candidates(j, m, r + 1);
+}
+
+struct Code93Symbology {
+  static const uint8_t ELEMENTS = 6; // 3 bars + 3 spaces, 9 modules
+  static const uint8_t WIDTH_CLASSES = 4;
+  static const uint8_t WIDE_ELEMENTS = 0;
+  static const uint8_t MODULES = 9;
+  static const uint8_t START_ELEMENTS = 6; // '*'
+  static const uint8_t CHARS_PER_SYMBOL = 1;
+  static const uint8_t CHECK_CHARS = 2; // C and K
+  static const bool INTERCHAR_GAP = false;
+  static const char STOP_CHAR = '*';
+  static const uint8_t STOP_ELEMENTS = 0;
+
+  static const uint8_t SYMBOLS = 48;
+  static const uint8_t STOP_SYMBOL = 47;
+
+  typedef uint64_t Candidates;
+  static const Candidates ALL_CANDIDATES = ((uint64_t) 1 << 48) - 1;
+
+  static constexpr Candidates candidates(uint8_t j, uint8_t m) {
+    return code93Candidates(j, m);
+  }
+
+  static bool anyCandidate(Candidates c) { return c != 0; }
+
+  static uint8_t startWidth(uint8_t i) {
+    return ((code93Widths[STOP_SYMBOL] >> (10 - 2 * i)) & 3) + 1;
+  }
+
+  static uint8_t decode(const uint8_t w[ELEMENTS], char out[]) {
+    uint16_t packed = 0;
+    uint8_t modules = 0;
+    for (uint8_t j = 0; j < ELEMENTS; j++) {
+      packed = (packed << 2) | (w[j] - 1);
+      modules += w[j];
+    }
+    if (modules != 9) return 0;
+    for (uint8_t r = 0; r < 48; r++) {
+      if (code93Widths[r] == packed) {
+        out[0] = code93Chars[r];
+        return 1;
+      }
+    }
+    return 0; // no match
+  }
+
+  static uint8_t stopWidth(uint8_t) { return 1; } // no stop pattern
+  static bool isStop(const uint8_t *, uint8_t) { return false; }
+
+  /*
+   *returns: checksum value of c, or -1 if it isn't a Code 93 character
+   */
+  static int8_t value(char c) {
+    for (int8_t v = 0; v < 47; v++) {
+      if (code93Chars[v] == c) return v;
+    }
+    return -1;
+  }
+
+  /*
+   *Checks that s[len] is the weighted mod-47 sum of s[0..len), weights
+   *counting up from 1 at the right and wrapping after maxWeight
+   */
+  static bool checkChar(const char *s, uint8_t len, uint8_t maxWeight) {
+    uint16_t sum = 0;
+    uint8_t weight = 1;
+    for (int8_t i = len - 1; i >= 0; i--) {
+      sum += value(s[i]) * weight;
+      if (++weight > maxWeight) weight = 1;
+    }
+    return (int8_t) (sum % 47) == value(s[len]);
+  }
+
+  static bool checksum(char *s, uint8_t &len) {
+    if (len < CHECK_CHARS) return false;
+    uint8_t dataLen = len - CHECK_CHARS;
+    if (!checkChar(s, dataLen, 20) || !checkChar(s, dataLen + 1, 15)) {
+      return false;
+    }
+    //Full-ASCII shift pairs can't be shown on the display, so reject them
+    for (uint8_t i = 0; i < dataLen; i++) {
+      if (value(s[i]) > 42) return false;
+    }
+    len = dataLen;
+    s[len] = '\0';
+    return true;
+  }
+
+  static void symbolWidths(uint8_t r, uint8_t w[ELEMENTS]) {
+    for (uint8_t j = 0; j < ELEMENTS; j++) {
+      w[j] = ((code93Widths[r] >> (10 - 2 * j)) & 3) + 1;
+    }
+  }
+
+  static uint8_t symbolChars(uint8_t r, char out[]) {
+    out[0] = code93Chars[r];
+    return 1;
+  }
+};
+
+#endif
@@ -0,0 +1,349 @@
+/*
+ *Host tool: grid search over the firmware's hand-picked constants (the
+ *follower speeds, FILTER_SHIFT, EDGE_HYSTERESIS, MIN_TICKS and
+ *BLACK_EDGE_MIN) using simulated scans of a fixed label corpus, spread over
+ *every core. Only configurations that reach the target read rate with no
+ *wrong accepts count; they are ranked on labels per minute, then on the mean
+ *confidence of their reads. Faster scans give each element fewer samples, so
+ *the target read rate is what holds the speed back. With thousands of
+ *configurations the top of the grid is partly luck, so the leaders are
+ *scanned again on a fresh, larger corpus before the best one is written out
+ *as tuned_params.h (next to params.h, which picks it up in place of its
+ *defaults). A winner on the edge of the grid gets a warning: the best value
+ *may lie past it.
+ *
+ *Only the forward speed is searched; the turn speeds keep their hand-picked
+ *ratio to it, so the follower steers the same way at any speed. The
+ *simulator doesn't follow a line, so the speed range stops at what the
+ *follower is trusted to track (SPEED_RANGE). WIDE_FACTOR isn't searched: the
+ *decoder doesn't use it, so the read rate can't tell its values apart.
+ *
+ *Build (from tools/): g++ -std=c++11 -O2 -pthread autotune.cpp -o autotune
+ *Usage: ./autotune [labels per config] [target read %] [output header]
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "label_sim.h"
+
+typedef Code39Symbology Sym;
+
+const double LABEL_OVERHEAD_MS = 1000; //placing the robot and pressing B
+const size_t FINALISTS = 10; //leaders re-checked on the bigger corpus
+const int RECHECK_FACTOR = 4; //bigger corpus = this many times the labels
+
+//One point of the search
+struct Config {
+  int speed;        // FWD_L_SLOW and FWD_R_SLOW
+  int filterShift;  // FILTER_SHIFT
+  int hysteresis;   // EDGE_HYSTERESIS
+  int minTicks;     // MIN_TICKS
+  int blackEdgeMin; // BLACK_EDGE_MIN
+};
+
+//Values one constant is searched over
+struct GridRange {
+  const char *name;
+  int lo, hi, step;
+};
+
+//0 is as low as FILTER_SHIFT, EDGE_HYSTERESIS and MIN_TICKS go, so only the
+//other edges of the grid can hide a better value. The top speed is three
+//times the hand-picked one: past it the follower would have to be tried on
+//the track first
+const GridRange SPEED_RANGE = {"FWD_L_SLOW", 20, 105, 5};
+const GridRange SHIFT_RANGE = {"FILTER_SHIFT", 0, 3, 1};
+const GridRange BAND_RANGE = {"EDGE_HYSTERESIS", 0, 250, 50};
+const GridRange TICKS_RANGE = {"MIN_TICKS", 0, 10, 2};
+const GridRange BLACK_RANGE = {"BLACK_EDGE_MIN", 300, 700, 50};
+
+struct Score {
+  double readRate;
+  double wrongRate;
+  double labelsPerMin;   // a failed read counts as a wasted pass
+  double meanConfidence; // of the labels read
+};
+
+/*
+ *Every configuration of the grid
+ */
+std::vector<Config> makeGrid() {
+  std::vector<Config> grid;
+  const GridRange &V = SPEED_RANGE, &S = SHIFT_RANGE, &B = BAND_RANGE,
+                  &T = TICKS_RANGE, &K = BLACK_RANGE;
+  for (int speed = V.lo; speed <= V.hi; speed += V.step) {
+    for (int shift = S.lo; shift <= S.hi; shift += S.step) {
+      for (int band = B.lo; band <= B.hi; band += B.step) {
+        for (int minTicks = T.lo; minTicks <= T.hi; minTicks += T.step) {
+          for (int black = K.lo; black <= K.hi; black += K.step) {
+            if (black - band <= 0 || black + band >= 1000) continue;
+            Config c = {speed, shift, band, minTicks, black};
+            grid.push_back(c);
+          }
+        }
+      }
+    }
+  }
+  return grid;
+}
+
+/*
+ *Simulator settings for a configuration
+ */
+ScanModel modelFor(const Config &c) {
+  ScanModel m;
+  m.ticksPerMs = 0.36 * c.speed / 35.0;
+  m.filterShift = c.filterShift;
+  m.hysteresis = c.hysteresis / 1000.0;
+  m.minTicks = c.minTicks;
+  m.blackThreshold = c.blackEdgeMin / 1000.0;
+  return m;
+}
+
+/*
+ *Turn speed for forward speed fwd, keeping the hand-picked ratio
+ *turn: TURN_L_SLOW or TURN_R_SLOW
+ */
+int turnSpeed(int fwd, int turn) {
+  return (fwd * turn + FWD_L_SLOW / 2) / FWD_L_SLOW;
+}
+
+/*
+ *Scans and decodes the whole corpus with one configuration
+ *seed: keeps every configuration's noise reproducible
+ */
+Score evaluate(const Config &c, const std::vector<std::string> &corpus,
+               unsigned seed) {
+  std::mt19937 rng(seed);
+  ScanModel model = modelFor(c);
+
+  int ok = 0, wrong = 0;
+  long confidence = 0;
+  double totalMs = 0;
+  for (size_t n = 0; n < corpus.size(); n++) {
+    std::vector<uint8_t> symbols;
+    encodeText<Sym>(corpus[n], symbols);
+    SimScan scan = simulateScan<Sym>(symbols, model, rng);
+
+    std::string got;
+    bool early;
+    uint8_t conf = scanText<Sym>(scan, WIDE_FACTOR, got, early);
+    if (conf >= MIN_CONFIDENCE && got == corpus[n]) {
+      ok++;
+      confidence += conf;
+    } else if (conf >= MIN_CONFIDENCE) {
+      wrong++;
+    }
+    totalMs += scan.printedTicks / model.ticksPerMs + LABEL_OVERHEAD_MS;
+  }
+  Score s;
+  s.readRate = 100.0 * ok / corpus.size();
+  s.wrongRate = 100.0 * wrong / corpus.size();
+  s.labelsPerMin = ok * 60000.0 / totalMs;
+  s.meanConfidence = ok ? (double) confidence / ok : 0;
+  return s;
+}
+
+/*
+ *Writes the firmware constants for c
+ *returns: false if the file couldn't be written
+ */
+bool writeHeader(const char *path, const Config &c, const Score &s,
+                 int perConfig, double target) {
+  FILE *f = fopen(path, "w");
+  if (!f) return false;
+  fprintf(f,
+          "/*\n"
+          " *Generated by tools/autotune, do not edit. Delete this file to go\n"
+          " *back to the defaults in params.h\n"
+          " *\n"
+          " *Target read rate %.1f%% over %d simulated labels per configuration\n"
+          " *Best: %.1f labels/min, %.2f%% read, %.1f%% mean confidence\n"
+          " */\n\n"
+          "#ifndef TUNED_PARAMS_H\n"
+          "#define TUNED_PARAMS_H\n\n",
+          target, perConfig, s.labelsPerMin, s.readRate, s.meanConfidence);
+  fprintf(f, "const uint16_t BLACK_EDGE_MIN = %d;\n\n", c.blackEdgeMin);
+  fprintf(f, "const int16_t FWD_L_SLOW = %d;\n", c.speed);
+  fprintf(f, "const int16_t FWD_R_SLOW = %d;\n", c.speed);
+  fprintf(f, "const int16_t TURN_L_SLOW = %d;\n",
+          turnSpeed(c.speed, TURN_L_SLOW));
+  fprintf(f, "const int16_t TURN_R_SLOW = %d;\n\n",
+          turnSpeed(c.speed, TURN_R_SLOW));
+  fprintf(f, "const uint8_t FILTER_SHIFT = %d;\n", c.filterShift);
+  fprintf(f, "const uint16_t EDGE_HYSTERESIS = %d;\n", c.hysteresis);
+  fprintf(f, "const long MIN_TICKS = %d;\n\n", c.minTicks);
+  fprintf(f, "#endif\n");
+  fclose(f);
+  return true;
+}
+
+/*
+ *Warns if v sits on an edge of its range that isn't 0
+ *returns: true if it warned
+ */
+bool warnEdge(const GridRange &r, int v) {
+  if ((v != r.lo || r.lo == 0) && v != r.hi) return false;
+  printf("warning: %s = %d is on the edge of the grid (%d..%d), the best value "
+         "may lie past it\n",
+         r.name, v, r.lo, r.hi);
+  return true;
+}
+
+/*
+ *Where tuned_params.h goes by default: next to params.h, found from this
+ *source file's path (as it was built) or else from the binary's, so it
+ *doesn't depend on the directory autotune is run from as long as either
+ *path still leads to the source tree
+ *returns: empty if neither does
+ */
+std::string defaultOutput(const char *argv0) {
+  const char *paths[] = {__FILE__, argv0};
+  for (size_t i = 0; i < 2; i++) {
+    std::string dir = paths[i];
+    size_t slash = dir.rfind('/');
+    dir = (slash == std::string::npos) ? "" : dir.substr(0, slash + 1);
+    FILE *f = fopen((dir + "../params.h").c_str(), "r");
+    if (f) {
+      fclose(f);
+      return dir + "../tuned_params.h";
+    }
+  }
+  return "";
+}
+
+/*
+ *Random labels of 1 to MAX_DATA_CHARS characters
+ */
+std::vector<std::string> makeCorpus(int count, unsigned seed) {
+  std::vector<std::string> corpus;
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> lenDist(1, MAX_DATA_CHARS);
+  std::uniform_int_distribution<int> charDist(0, 42);
+  for (int n = 0; n < count; n++) {
+    std::string text;
+    int len = lenDist(rng);
+    for (int i = 0; i < len; i++) text += code39[charDist(rng)][0];
+    corpus.push_back(text);
+  }
+  return corpus;
+}
+
+/*
+ *Scores every configuration in configs against corpus on all cores
+ *seed: noise of configuration i is seeded with seed + i
+ */
+std::vector<Score> evaluateAll(const std::vector<Config> &configs,
+                               const std::vector<std::string> &corpus,
+                               unsigned seed, unsigned threads) {
+  std::vector<Score> scores(configs.size());
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; t++) {
+    pool.push_back(std::thread([&]() {
+      for (size_t i = next++; i < configs.size(); i = next++) {
+        scores[i] = evaluate(configs[i], corpus, seed + (unsigned) i);
+      }
+    }));
+  }
+  for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+  return scores;
+}
+
+/*
+ *returns: true if s counts at all
+ */
+bool qualifies(const Score &s, double target) {
+  return s.readRate >= target && s.wrongRate == 0;
+}
+
+/*
+ *returns: true if a ranks above b
+ */
+bool beats(const Score &a, const Score &b) {
+  if (a.labelsPerMin != b.labelsPerMin) return a.labelsPerMin > b.labelsPerMin;
+  return a.meanConfidence > b.meanConfidence;
+}
+
+int main(int argc, char **argv) {
+  int perConfig = (argc > 1) ? atoi(argv[1]) : 500;
+  double target = (argc > 2) ? atof(argv[2]) : 99.0;
+  std::string out = (argc > 3) ? argv[3] : defaultOutput(argv[0]);
+  if (out.empty()) {
+    printf("can't find params.h, give the output header\n");
+    return 2;
+  }
+
+  unsigned threads = std::thread::hardware_concurrency();
+  if (threads == 0) threads = 4;
+
+  //1) Whole grid, same labels for every configuration
+  std::vector<std::string> corpus = makeCorpus(perConfig, 243);
+  std::vector<Config> grid = makeGrid();
+  std::vector<Score> scores = evaluateAll(grid, corpus, 1000, threads);
+  printf("%zu configs x %d labels on %u threads, target %.1f%% read\n",
+         grid.size(), perConfig, threads, target);
+
+  //2) Re-check the leaders (and the current constants) on fresh labels
+  std::vector<Config> finalists;
+  std::vector<bool> taken(grid.size(), false);
+  while (finalists.size() < FINALISTS) {
+    long lead = -1;
+    for (size_t i = 0; i < grid.size(); i++) {
+      if (taken[i] || !qualifies(scores[i], target)) continue;
+      if (lead < 0 || beats(scores[i], scores[lead])) {
+        lead = (long) i;
+      }
+    }
+    if (lead < 0) break;
+    taken[lead] = true;
+    finalists.push_back(grid[lead]);
+  }
+  Config current = {FWD_L_SLOW, FILTER_SHIFT,
+                    EDGE_HYSTERESIS, (int) MIN_TICKS, BLACK_EDGE_MIN};
+  finalists.push_back(current);
+
+  int recheck = perConfig * RECHECK_FACTOR;
+  std::vector<std::string> fresh = makeCorpus(recheck, 244);
+  std::vector<Score> final = evaluateAll(finalists, fresh, 5000, threads);
+
+  long best = -1;
+  for (size_t i = 0; i < finalists.size(); i++) {
+    const Config &c = finalists[i];
+    printf("%s speed %3d  shift %d  band %3d  minTicks %2d  black %d"
+           "  -> %6.2f%% read, %4.1f%% confidence, %5.1f labels/min\n",
+           (i + 1 == finalists.size()) ? "current:" : "        ",
+           c.speed, c.filterShift, c.hysteresis, c.minTicks,
+           c.blackEdgeMin, final[i].readRate, final[i].meanConfidence,
+           final[i].labelsPerMin);
+    if (!qualifies(final[i], target)) continue;
+    if (best < 0 || beats(final[i], final[best])) {
+      best = (long) i;
+    }
+  }
+  if (best < 0) {
+    printf("no configuration reaches the target\n");
+    return 1;
+  }
+
+  const Config &c = finalists[best];
+  warnEdge(SPEED_RANGE, c.speed);
+  warnEdge(SHIFT_RANGE, c.filterShift);
+  warnEdge(BAND_RANGE, c.hysteresis);
+  warnEdge(TICKS_RANGE, c.minTicks);
+  warnEdge(BLACK_RANGE, c.blackEdgeMin);
+  if (!writeHeader(out.c_str(), c, final[best], recheck, target)) {
+    printf("couldn't write %s\n", out.c_str());
+    return 1;
+  }
+  printf("wrote %s\n", out.c_str());
+  return 0;
+}
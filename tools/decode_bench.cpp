@@ -0,0 +1,87 @@
+/*
+ *Host benchmark: first-pass read rate of the whole-label decoder against the
+ *old per-element threshold decoder, over a corpus of random simulated labels
+ *at increasing scan speeds.
+ *
+ *Build (from tools/): g++ -std=c++11 -O2 decode_bench.cpp -o decode_bench
+ *Usage: ./decode_bench [labels per speed]
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "label_sim.h"
+
+typedef Code39Symbology Sym;
+
+/*
+ *Old decoder: one cutoff from the start pattern, hard N/W call per element,
+ *first unmatched symbol fails the label
+ *returns: true if the label read back as text
+ */
+bool hardRead(const SimScan &scan, const std::string &text) {
+  if (scan.start.size() < Sym::START_ELEMENTS) return false;
+  Width narrow = Width::fromInt(10), ratio = DEFAULT_WIDE_RATIO;
+  startReference<Sym>(scan.start.data(), narrow, ratio);
+  Width cutoffs[Sym::WIDTH_CLASSES - 1];
+  widthCutoffs<Sym>(narrow, WIDE_FACTOR, cutoffs);
+
+  std::string got;
+  const size_t P = chunkElements<Sym>(), GAP = Sym::INTERCHAR_GAP ? 1 : 0;
+  for (size_t s = 0; s + P <= scan.elements.size(); s += P) {
+    uint8_t pattern[Sym::ELEMENTS];
+    for (uint8_t j = 0; j < Sym::ELEMENTS; j++) {
+      pattern[j] = classifyWidth<Sym>(
+          Width::fromInt(scan.elements[s + GAP + j]), cutoffs);
+    }
+    char letters[Sym::CHARS_PER_SYMBOL];
+    uint8_t n = Sym::decode(pattern, letters);
+    if (n == 0) return false;
+    if (letters[0] == Sym::STOP_CHAR) return got == text;
+    got.append(letters, n);
+  }
+  return false;
+}
+
+int main(int argc, char **argv) {
+  int perSpeed = (argc > 1) ? atoi(argv[1]) : 20000;
+  std::mt19937 rng(243);
+  std::uniform_int_distribution<int> lenDist(1, MAX_DATA_CHARS);
+  std::uniform_int_distribution<int> charDist(0, 42);
+
+  printf("speed  ticks/ms  hard read  whole-label read  wrong accepts  "
+         "prefix rejects\n");
+  for (int speed = 35; speed <= 175; speed += 20) {
+    ScanModel model;
+    model.ticksPerMs = 0.36 * speed / 35.0;
+    int hardOk = 0, softOk = 0, softWrong = 0, softEarly = 0;
+    for (int n = 0; n < perSpeed; n++) {
+      std::string text;
+      int len = lenDist(rng);
+      for (int i = 0; i < len; i++) {
+        char c = code39[charDist(rng)][0];
+        text += c;
+      }
+      std::vector<uint8_t> symbols;
+      encodeText<Sym>(text, symbols);
+      SimScan scan = simulateScan<Sym>(symbols, model, rng);
+
+      bool wrong = false, early = false;
+      hardOk += hardRead(scan, text);
+      softOk += simRead<Sym>(scan, text, WIDE_FACTOR, wrong, early);
+      softWrong += wrong;
+      softEarly += early;
+    }
+    printf("%5d  %8.2f  %8.1f%%  %15.1f%%  %12.2f%%  %13.2f%%\n", speed,
+           model.ticksPerMs, 100.0 * hardOk / perSpeed,
+           100.0 * softOk / perSpeed, 100.0 * softWrong / perSpeed,
+           100.0 * softEarly / perSpeed);
+  }
+  return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ *Host-side simulation of the robot scanning a printed label. Produces the same
+ *raw element widths (encoder ticks) the firmware records, with the errors that
+ *get worse as the robot speeds up:
+ *  - edges are only seen on a sensor sample, and a change then takes some
+ *    samples to get through the outer sensor filter (FILTER_SHIFT) past the
+ *    EDGE_HYSTERESIS band: more one way than the other unless the band is
+ *    centred, which skews every bar's width
+ *  - an element gone before the filter gets across (which depends on where
+ *    the samples fall) or within MIN_TICKS is missed and merges with its
+ *    neighbours
+ *  - the sensor spot is not a point, so where BLACK_EDGE_MIN sits between
+ *    white and black moves every edge: bars read wider for a low threshold
+ *    (the hysteresis band moves both edges of an element alike, so cancels)
+ *  - noise that still reaches across the band after filtering makes a spike;
+ *    one lasting MIN_TICKS splits an element in three
+ *  - the follower steers by changing wheel speeds, so the left encoder reads
+ *    each element a little long or short
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#ifndef LABEL_SIM_H
+#define LABEL_SIM_H
+
+#include <stdint.h>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "../params.h"
+#include "../symbology.h"
+#include "../labeldecode.h"
+
+struct ScanModel {
+  double narrowTicks = 15;    // printed narrow element (about 4 mm)
+  double wideRatio = 2.5;     // printed wide / narrow
+  double gapRatio = 1.0;      // printed inter-character gap / narrow
+  double inkSpread = 1.0;     // bars print this much wider, spaces narrower
+  double ticksPerMs = 0.36;   // travel speed (about 100 mm/s at speed 35)
+  double samplePeriodMs = 2.0; // readCalibrated() + gyro read + follower
+  double filterShift = 1;     // FILTER_SHIFT
+  double hysteresis = 0.1;    // EDGE_HYSTERESIS / 1000
+  double minTicks = 5;        // MIN_TICKS
+  double blackThreshold = 0.5; // BLACK_EDGE_MIN / 1000 (calibrated range)
+  double apertureTicks = 2;   // travel for a sensor to go from white to black
+  double sensorNoise = 0.08;  // spread of a reading, as a fraction of the range
+  double glitchMs = 4.0;      // longest a noise spike lasts
+  double wheelNoise = 0.10;   // relative spread of the left wheel per element
+};
+
+//One pass over a label (simulated, or a scanline of an image), laid out like
+//the firmware's buffers
+struct SimScan {
+  std::vector<uint16_t> start;    // start pattern widths
+  std::vector<uint16_t> elements; // every later element, up to the quiet zone
+  double printedTicks;            // length of the whole label
+};
+
+/*
+ *Encodes text (data characters only) into the symbols of the label, in
+ *symbol-index form, start and stop excluded
+ *returns: false if some character can't be encoded
+ */
+template <class Sym>
+bool encodeText(const std::string &text, std::vector<uint8_t> &out) {
+  out.clear();
+  for (size_t i = 0; i < text.size(); i += Sym::CHARS_PER_SYMBOL) {
+    uint8_t found = NO_SYMBOL;
+    for (uint8_t r = 0; r < Sym::SYMBOLS && found == NO_SYMBOL; r++) {
+      if (r == Sym::STOP_SYMBOL) continue;
+      char c[Sym::CHARS_PER_SYMBOL];
+      Sym::symbolChars(r, c);
+      if (text.compare(i, Sym::CHARS_PER_SYMBOL,
+                       std::string(c, Sym::CHARS_PER_SYMBOL)) == 0) {
+        found = r;
+      }
+    }
+    if (found == NO_SYMBOL) return false;
+    out.push_back(found);
+  }
+  return true;
+}
+
+/*
+ *Splits element widths into the start pattern and the rest, the way the
+ *firmware records them
+ *widths: every element from the first bar of the start pattern on, ending
+ *with the white after the label (left out)
+ */
+template <class Sym>
+void splitScan(const std::vector<uint16_t> &widths, SimScan &scan) {
+  size_t i = (widths.size() < Sym::START_ELEMENTS) ? widths.size()
+                                                    : Sym::START_ELEMENTS;
+  scan.start.assign(widths.begin(), widths.begin() + i);
+  scan.elements.clear();
+  if (i + 1 < widths.size()) {
+    scan.elements.assign(widths.begin() + i, widths.end() - 1);
+  }
+}
+
+/*
+ *Simulates one scan of a label
+ *symbols: data symbols from encodeText() (plus any check characters)
+ */
+template <class Sym>
+SimScan simulateScan(const std::vector<uint8_t> &symbols, const ScanModel &m,
+                     std::mt19937 &rng) {
+  std::uniform_real_distribution<double> phase(0.0, 1.0);
+  std::normal_distribution<double> wheel(1.0, m.wheelNoise);
+
+  //Printed element widths and colours (true = black bar)
+  std::vector<double> printed;
+  std::vector<bool> black;
+  //Bars grow by the part of the sensor spot past the threshold
+  double spread = m.inkSpread + m.apertureTicks * (1 - 2 * m.blackThreshold);
+  auto addElement = [&](uint8_t modules, bool bar) {
+    double w = (modules == 1) ? m.narrowTicks
+               : (Sym::WIDTH_CLASSES == 2) ? m.narrowTicks * m.wideRatio
+                                            : m.narrowTicks * modules;
+    printed.push_back(w + (bar ? spread : -spread));
+    black.push_back(bar);
+  };
+
+  bool bar = true;
+  for (uint8_t j = 0; j < Sym::START_ELEMENTS; j++) {
+    addElement(Sym::startWidth(j), bar);
+    bar = !bar;
+  }
+  std::vector<uint8_t> all(symbols);
+  if (Sym::STOP_SYMBOL != NO_SYMBOL) all.push_back((uint8_t) Sym::STOP_SYMBOL);
+  for (size_t k = 0; k < all.size(); k++) {
+    if (Sym::INTERCHAR_GAP) {
+      printed.push_back(m.narrowTicks * m.gapRatio - spread);
+      black.push_back(false);
+      bar = true;
+    }
+    uint8_t w[Sym::ELEMENTS];
+    Sym::symbolWidths(all[k], w);
+    for (uint8_t j = 0; j < Sym::ELEMENTS; j++) {
+      addElement(w[j], bar);
+      bar = !bar;
+    }
+  }
+  for (uint8_t j = 0; j < Sym::STOP_ELEMENTS; j++) {
+    addElement(Sym::stopWidth(j), bar);
+    bar = !bar;
+  }
+  SimScan scan;
+  scan.printedTicks = 0;
+  for (size_t i = 0; i < printed.size(); i++) scan.printedTicks += printed[i];
+
+  //Quiet zone after the label
+  printed.push_back(m.narrowTicks * 20);
+  black.push_back(false);
+
+  //Edges as the firmware sees them. Readings come on a fixed grid of samples
+  //(random phase), and the filter needs a number of them to get across the
+  //band that depends on the direction: each edge counts that many samples
+  //after the first one past it. An element that ends before the filter gets
+  //across (or within MIN_TICKS) is lost, and takes both of its edges with it
+  double step = m.samplePeriodMs * m.ticksPerMs;
+  double alpha = pow(0.5, m.filterShift);
+  double toBlack = m.blackThreshold + m.hysteresis;
+  double toWhite = 1 - (m.blackThreshold - m.hysteresis);
+  auto samplesFor = [&](double f) {
+    return (alpha >= 1 || f >= 1) ? 1 : ceil(log(1 - f) / log(1 - alpha));
+  };
+  double lagToBlack = (samplesFor(toBlack) - 1) * step;
+  double lagToWhite = (samplesFor(toWhite) - 1) * step;
+  double grid = phase(rng) * step;
+  auto seenAt = [&](double edge, bool toBar) {
+    double first = grid + ceil((edge - grid) / step) * step;
+    return first + (toBar ? lagToBlack : lagToWhite);
+  };
+  //Noise has to reach from the element's own color past the far side of the
+  //band, and the filter takes sqrt(alpha / (2 - alpha)) of it off
+  double noise = m.sensorNoise * sqrt(alpha / (2 - alpha));
+  std::bernoulli_distribution spikeOnWhite(
+      exp(-toBlack * toBlack / (2 * noise * noise)));
+  std::bernoulli_distribution spikeOnBlack(
+      exp(-toWhite * toWhite / (2 * noise * noise)));
+  std::vector<double> measured;
+  std::vector<bool> measuredBlack;
+  double x = 0;                 // printed position of the element's start
+  double seenStart = seenAt(0, true);
+  for (size_t i = 0; i < printed.size(); i++) {
+    bool colour = black[i];
+    double end = x + printed[i];
+    double seenEnd = seenAt(end, !colour);
+    while (i + 2 < printed.size()) {
+      double next = end + printed[i + 1];
+      if (seenEnd < next && seenAt(next, colour) - seenEnd >= m.minTicks) {
+        break;
+      }
+      end = next + printed[i + 2];
+      seenEnd = seenAt(end, !colour);
+      i += 2;
+    }
+    if (i + 1 == printed.size()) seenEnd = end; // quiet zone, never left
+    double w = (seenEnd - seenStart) * wheel(rng);
+    x = end;
+    seenStart = seenEnd;
+
+    double glitchMs = phase(rng) * m.glitchMs;
+    double glitch = glitchMs * m.ticksPerMs;
+    double at = phase(rng) * (w - glitch);
+    bool spike = colour ? spikeOnBlack(rng) : spikeOnWhite(rng);
+    if (spike && glitch >= m.minTicks && at > 0) {
+      measured.push_back(at);
+      measuredBlack.push_back(colour);
+      measured.push_back(glitch);
+      measuredBlack.push_back(!colour);
+      w -= at + glitch;
+    }
+    measured.push_back(w);
+    measuredBlack.push_back(colour);
+  }
+
+  std::vector<uint16_t> widths;
+  for (size_t i = 0; i < measured.size(); i++) {
+    double w = measured[i];
+    widths.push_back((uint16_t) (w < 0 ? 0 : w + 0.5));
+  }
+  splitScan<Sym>(widths, scan);
+  return scan;
+}
+
+/*
+ *Decodes a scan the way readBarcode() does: early rejection while scanning,
+ *then the whole label at the stop
+ *wideFactor: WIDE_FACTOR to decode with
+ *text: decoded label (empty if it didn't read)
+ *early: set if LiveAligner would have stopped the robot on the label
+ *returns: confidence 0-100, below MIN_CONFIDENCE if it didn't read
+ */
+template <class Sym>
+uint8_t scanText(const SimScan &scan, Width wideFactor, std::string &text,
+                 bool &early) {
+  text.clear();
+  early = false;
+  if (scan.start.size() < Sym::START_ELEMENTS || scan.elements.empty()) {
+    return 0;
+  }
+  Width narrow = Width::fromInt(10), ratio = DEFAULT_WIDE_RATIO;
+  startReference<Sym>(scan.start.data(), narrow, ratio);
+  Width cutoffs[Sym::WIDTH_CLASSES - 1];
+  widthCutoffs<Sym>(narrow, wideFactor, cutoffs);
+
+  const uint8_t maxSymbols =
+      (MAX_DATA_CHARS + Sym::CHECK_CHARS + Sym::CHARS_PER_SYMBOL - 1) /
+          Sym::CHARS_PER_SYMBOL + 1;
+  const uint8_t maxElements =
+      maxSymbols * chunkElements<Sym>() + MAX_SLIP + Sym::STOP_ELEMENTS;
+  uint16_t stream[maxElements];
+  uint8_t n = 0;
+  LiveAligner<Sym, MAX_SLIP> aligner;
+  aligner.begin(cutoffs, prefixGuard<Sym>(narrow, ratio, PREFIX_GUARD));
+  for (size_t i = 0; i < scan.elements.size(); i++) {
+    if (n == maxElements) return 0;
+    stream[n++] = scan.elements[i];
+    LiveEvent ev = aligner.see(stream, n);
+    if (ev == LIVE_BAD) {
+      early = true;
+      return 0;
+    }
+    if (ev != LIVE_SYMBOL) continue;
+    SymbolScore sc;
+    scoreSymbol<Sym>(stream + aligner.symbolStart(), ratio, sc);
+    if (looksLikeStop<Sym>(sc)) break;
+  }
+  if (aligner.finish(n) == LIVE_BAD) return 0;
+
+  if (Sym::STOP_ELEMENTS > 0) {
+    uint8_t pattern[Sym::STOP_ELEMENTS + 1];
+    if (n < Sym::STOP_ELEMENTS) return 0;
+    n -= Sym::STOP_ELEMENTS;
+    for (uint8_t i = 0; i < Sym::STOP_ELEMENTS; i++) {
+      pattern[i] = classifyWidth<Sym>(Width::fromInt(stream[n + i]), cutoffs);
+    }
+    if (!Sym::isStop(pattern, Sym::STOP_ELEMENTS)) return 0;
+  }
+
+  char out[maxSymbols * Sym::CHARS_PER_SYMBOL + 1];
+  uint8_t len = 0;
+  uint8_t confidence = decodeLabel<Sym, maxSymbols, MAX_SLIP>(
+      stream, n, ratio, MAX_SYMBOL_COST, SLIP_COST, out, len);
+  if (confidence < MIN_CONFIDENCE || len > MAX_DATA_CHARS) return 0;
+  text = out;
+  return confidence;
+}
+
+/*
+ *Decodes a simulated scan (see scanText())
+ *wrong: set if a label was accepted with the wrong text
+ *returns: true if the label read back as text
+ */
+template <class Sym>
+bool simRead(const SimScan &scan, const std::string &text, Width wideFactor,
+             bool &wrong, bool &early) {
+  std::string got;
+  wrong = false;
+  if (scanText<Sym>(scan, wideFactor, got, early) < MIN_CONFIDENCE) {
+    return false;
+  }
+  wrong = (got != text);
+  return !wrong;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ *Host regression check: a misprinted symbol has to come back as Bad Code,
+ *never quietly corrected. Builds *H?* labels with exact widths, where ? is
+ *every data symbol with one of its narrow elements printed wide (4 wide, so
+ *no valid symbol), and decodes each one like the firmware does (scanText()).
+ *The same labels printed correctly have to read.
+ *
+ *Build (from tools/): g++ -std=c++11 -O2 misprint_check.cpp -o misprint_check
+ *Usage: ./misprint_check
+ *Prints every misprint that was accepted and exits with 1 if there was one
+ *(or a clean label didn't read).
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "label_sim.h"
+
+typedef Code39Symbology Sym;
+
+const uint16_t NARROW_TICKS = 10;
+const uint16_t WIDE_TICKS = 25;
+
+/*
+ *Appends the gap and the elements of symbol r, with element bad (if any)
+ *printed wide
+ */
+void addSymbol(uint8_t r, int bad, std::vector<uint16_t> &elements) {
+  uint8_t w[Sym::ELEMENTS];
+  Sym::symbolWidths(r, w);
+  elements.push_back(NARROW_TICKS);
+  for (int j = 0; j < Sym::ELEMENTS; j++) {
+    bool wide = w[j] > 1 || j == bad;
+    elements.push_back(wide ? WIDE_TICKS : NARROW_TICKS);
+  }
+}
+
+/*
+ *Scans *H?* with symbol r's element bad printed wide (-1: none)
+ *returns: confidence scanText() gave it; text is what it read
+ */
+uint8_t readLabel(uint8_t lead, uint8_t r, int bad, std::string &text) {
+  SimScan scan;
+  for (uint8_t j = 0; j < Sym::START_ELEMENTS; j++) {
+    scan.start.push_back((Sym::startWidth(j) > 1) ? WIDE_TICKS : NARROW_TICKS);
+  }
+  addSymbol(lead, -1, scan.elements);
+  addSymbol(r, bad, scan.elements);
+  addSymbol(Sym::STOP_SYMBOL, -1, scan.elements);
+  scan.printedTicks = 0;
+  bool early;
+  return scanText<Sym>(scan, WIDE_FACTOR, text, early);
+}
+
+int main() {
+  std::vector<uint8_t> lead;
+  encodeText<Sym>("H", lead);
+
+  int misprints = 0, accepted = 0, clean = 0, cleanOk = 0;
+  for (uint8_t r = 0; r < Sym::SYMBOLS; r++) {
+    if (r == Sym::STOP_SYMBOL) continue;
+    char c[Sym::CHARS_PER_SYMBOL];
+    Sym::symbolChars(r, c);
+    std::string want = "H" + std::string(c, Sym::CHARS_PER_SYMBOL);
+
+    std::string text;
+    clean++;
+    if (readLabel(lead[0], r, -1, text) >= MIN_CONFIDENCE && text == want) {
+      cleanOk++;
+    } else {
+      printf("clean label \"%s\" didn't read\n", want.c_str());
+    }
+
+    uint8_t w[Sym::ELEMENTS];
+    Sym::symbolWidths(r, w);
+    for (int j = 0; j < Sym::ELEMENTS; j++) {
+      if (w[j] > 1) continue;
+      misprints++;
+      uint8_t conf = readLabel(lead[0], r, j, text);
+      if (conf < MIN_CONFIDENCE) continue;
+      accepted++;
+      printf("misprint of '%c' element %d read as \"%s\" at %d%%\n", c[0], j,
+             text.c_str(), conf);
+    }
+  }
+  printf("%d/%d clean labels read, %d/%d misprints accepted\n", cleanOk, clean,
+         accepted, misprints);
+  return (accepted > 0 || cleanOk < clean) ? 1 : 0;
+}
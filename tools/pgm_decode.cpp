@@ -0,0 +1,369 @@
+/*
+ *Host tool: checks a batch of printed labels from grayscale scans before they
+ *go on the track. Each PGM image is cut into several horizontal scanlines
+ *across the middle of the label; every line is thresholded (SSE2 when the
+ *compiler has it, plain C++ otherwise), run-length encoded into element
+ *widths and decoded with the firmware's own decoder (labeldecode.h, through
+ *label_sim.h's scanText()). The lines then vote on the label's text. Images
+ *are spread over every core.
+ *
+ *Widths are kept in 1/SUBPIXEL of a pixel: each edge is placed where the
+ *threshold falls between its two pixels, so small prints still have usable
+ *narrow/wide ratios. Elements are capped at MAX_ELEMENT so a symbol's total
+ *stays in range of the decoder's fixed-point maths. A line is read from the
+ *first bar behind a quiet zone that gives a label, so specks in the margin
+ *don't throw it off.
+ *
+ *Build (from tools/): g++ -std=c++11 -O2 -pthread pgm_decode.cpp -o pgm_decode
+ *Usage: ./pgm_decode [-l scanlines] label.pgm...
+ *Prints one line per image (name, text or NO READ, votes, confidence) and
+ *exits with 1 if any image didn't read.
+ *
+ *Author: OCdt Flood & OCdt Lee
+ *Version: 12-11-2025
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "label_sim.h"
+
+typedef Code39Symbology Sym;
+
+const int DEFAULT_SCANLINES = 9;
+const double SCAN_BAND = 0.6; //scanlines spread over the middle 60% of rows
+const int SUBPIXEL = 4;       //width units per pixel
+const int MIN_CONTRAST = 40;  //darkest to lightest pixel of a line with a label
+const long MAX_ELEMENT = 3000; //widest element kept, in width units
+const long QUIET_NARROWS = 6; //white before a label, in narrows (spec is 10,
+                              //this leaves room for a small or blurred print)
+
+struct Image {
+  int width, height;
+  std::vector<uint8_t> pixels; // row by row, 0 = black
+};
+
+//What one image decoded to
+struct LabelResult {
+  bool loaded; // the file was a readable PGM
+  bool ok;
+  std::string text;
+  int votes;       // lines that read text
+  int lines;       // lines scanned
+  uint8_t confidence; // lowest confidence among the winning lines
+};
+
+//IMAGE INPUT
+
+/*
+ *Reads the next header number of a PGM, skipping whitespace and comments
+ *returns: false at end of file or on junk
+ */
+bool pgmNumber(FILE *f, int &out) {
+  int c = fgetc(f);
+  while (c != EOF) {
+    if (c == '#') {
+      while (c != EOF && c != '\n') c = fgetc(f);
+    } else if (c > ' ') {
+      break;
+    }
+    c = fgetc(f);
+  }
+  if (c < '0' || c > '9') return false;
+  out = 0;
+  while (c >= '0' && c <= '9') {
+    out = out * 10 + (c - '0');
+    c = fgetc(f);
+  }
+  return true; // the one whitespace after the number is consumed
+}
+
+/*
+ *Loads a binary (P5) or ASCII (P2) PGM, scaled to 8 bits
+ *returns: false if it isn't a readable PGM
+ */
+bool readPgm(const char *path, Image &img) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  char magic[2];
+  int maxval = 0;
+  bool ok = fread(magic, 1, 2, f) == 2 && magic[0] == 'P' &&
+            (magic[1] == '5' || magic[1] == '2') &&
+            pgmNumber(f, img.width) && pgmNumber(f, img.height) &&
+            pgmNumber(f, maxval) && img.width > 0 && img.height > 0 &&
+            maxval > 0 && maxval < 65536;
+  if (ok) {
+    size_t n = (size_t) img.width * img.height;
+    img.pixels.resize(n);
+    if (magic[1] == '5' && maxval < 256) {
+      ok = fread(img.pixels.data(), 1, n, f) == n;
+      if (ok && maxval != 255) {
+        for (size_t i = 0; i < n; i++) {
+          img.pixels[i] = (uint8_t) (img.pixels[i] * 255 / maxval);
+        }
+      }
+    } else {
+      for (size_t i = 0; i < n && ok; i++) {
+        int v = 0;
+        if (magic[1] == '2') {
+          ok = pgmNumber(f, v);
+        } else {
+          int hi = fgetc(f), lo = fgetc(f); // 16-bit samples, big-endian
+          ok = lo != EOF;
+          v = hi << 8 | lo;
+        }
+        img.pixels[i] = (uint8_t) ((long) v * 255 / maxval);
+      }
+    }
+  }
+  fclose(f);
+  return ok;
+}
+
+//SCANLINES
+
+/*
+ *Darkest and lightest pixel of a row
+ */
+void rowRange(const uint8_t *row, int n, uint8_t &lo, uint8_t &hi) {
+  int i = 0;
+  lo = 255;
+  hi = 0;
+#ifdef __SSE2__
+  if (n >= 16) {
+    __m128i vlo = _mm_set1_epi8((char) 0xFF), vhi = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (row + i));
+      vlo = _mm_min_epu8(vlo, v);
+      vhi = _mm_max_epu8(vhi, v);
+    }
+    uint8_t l[16], h[16];
+    _mm_storeu_si128((__m128i *) l, vlo);
+    _mm_storeu_si128((__m128i *) h, vhi);
+    for (int k = 0; k < 16; k++) {
+      if (l[k] < lo) lo = l[k];
+      if (h[k] > hi) hi = h[k];
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    if (row[i] < lo) lo = row[i];
+    if (row[i] > hi) hi = row[i];
+  }
+}
+
+/*
+ *Marks the pixels of a row darker than t, one bit per pixel (bit i % 64 of
+ *word i / 64)
+ */
+void thresholdRow(const uint8_t *row, int n, uint8_t t,
+                  std::vector<uint64_t> &bits) {
+  bits.assign((n + 63) / 64, 0);
+  int i = 0;
+#ifdef __SSE2__
+  // No unsigned byte compare in SSE2: flip the sign bits and compare signed
+  const __m128i flip = _mm_set1_epi8((char) 0x80);
+  const __m128i vt = _mm_xor_si128(_mm_set1_epi8((char) t), flip);
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (row + i)),
+                              flip);
+    uint64_t dark = (uint16_t) _mm_movemask_epi8(_mm_cmplt_epi8(v, vt));
+    bits[i >> 6] |= dark << (i & 63);
+  }
+#endif
+  for (; i < n; i++) {
+    if (row[i] < t) bits[i >> 6] |= (uint64_t) 1 << (i & 63);
+  }
+}
+
+/*
+ *Finds every color change of a row
+ *edges: where each change is, in width units
+ *startsDark: the row's first pixel is darker than the threshold
+ *returns: false if the row has no label in it
+ */
+bool rowEdges(const uint8_t *row, int n, std::vector<long> &edges,
+              bool &startsDark) {
+  edges.clear();
+  uint8_t lo, hi;
+  rowRange(row, n, lo, hi);
+  if (hi - lo < MIN_CONTRAST) return false;
+  uint8_t t = (uint8_t) ((lo + hi + 1) / 2);
+
+  std::vector<uint64_t> bits;
+  thresholdRow(row, n, t, bits);
+
+  // Run-length encode: every set bit of word ^ (word shifted by one pixel) is
+  // a color change. Each one is moved to where the threshold falls between
+  // the two pixels
+  uint64_t carry = bits[0] & 1; // treat the row as starting in its first color
+  startsDark = carry;
+  for (size_t w = 0; w < bits.size(); w++) {
+    uint64_t change = bits[w] ^ ((bits[w] << 1) | carry);
+    carry = bits[w] >> 63;
+    if ((w + 1) * 64 > (size_t) n) {
+      change &= ((uint64_t) 1 << (n - w * 64)) - 1; // past the row
+    }
+    while (change) {
+      int p = (int) (w * 64) + __builtin_ctzll(change);
+      change &= change - 1;
+      // a - t and a - b have the same sign either way round, rounded to the
+      // nearest width unit so neither edge of a bar is pulled one way
+      long a = row[p - 1], b = row[p];
+      long num = labs(a - t) * SUBPIXEL, den = labs(a - b);
+      edges.push_back((long) (p - 1) * SUBPIXEL + SUBPIXEL / 2 +
+                      (num + den / 2) / den);
+    }
+  }
+  return edges.size() >= 2;
+}
+
+/*
+ *Whether a label can start at white -> black edge k: it needs a quiet zone,
+ *QUIET_NARROWS times its first bar (a narrow one) of white in front of it,
+ *or nothing but white back to the edge of the image (a label cropped tight).
+ *A speck in the margin has too little white before it or the label, so it
+ *isn't taken for the first bar
+ */
+bool quietBefore(const std::vector<long> &edges, size_t k, int n) {
+  if (k == 0) return true;
+  long white = edges[k] - edges[k - 1];
+  long bar = ((k + 1 < edges.size()) ? edges[k + 1] : (long) n * SUBPIXEL) -
+             edges[k];
+  return white >= bar * QUIET_NARROWS;
+}
+
+/*
+ *Element widths from white -> black edge k to the white after the label
+ *(what splitScan() expects)
+ */
+void edgeWidths(const std::vector<long> &edges, size_t k, int n,
+                std::vector<uint16_t> &widths) {
+  widths.clear();
+  for (size_t i = k + 1; i <= edges.size(); i++) {
+    long end = (i < edges.size()) ? edges[i] : (long) n * SUBPIXEL;
+    long d = end - edges[i - 1];
+    widths.push_back((uint16_t) ((d > MAX_ELEMENT) ? MAX_ELEMENT : d));
+  }
+}
+
+/*
+ *Reads one row, trying each white -> black edge behind a quiet zone as the
+ *start of the label until one reads
+ *returns: confidence of the read, 0 if none did
+ */
+uint8_t readRow(const uint8_t *row, int n, std::string &text) {
+  std::vector<long> edges;
+  bool startsDark;
+  if (!rowEdges(row, n, edges, startsDark)) return 0;
+  std::vector<uint16_t> widths;
+  for (size_t k = startsDark ? 1 : 0; k + 1 < edges.size(); k += 2) {
+    if (!quietBefore(edges, k, n)) continue;
+    edgeWidths(edges, k, n, widths);
+    SimScan scan;
+    splitScan<Sym>(widths, scan);
+    bool early;
+    uint8_t c = scanText<Sym>(scan, WIDE_FACTOR, text, early);
+    if (c >= MIN_CONFIDENCE) return c;
+  }
+  return 0;
+}
+
+/*
+ *Reads every scanline of one image and lets them vote
+ */
+LabelResult decodeImage(const Image &img, int scanlines) {
+  LabelResult res = {true, false, "", 0, 0, 0};
+  std::map<std::string, int> votes;
+  std::map<std::string, uint8_t> lowest;
+
+  int first = (int) (img.height * (1 - SCAN_BAND) / 2);
+  int span = img.height - 2 * first;
+  for (int k = 0; k < scanlines; k++) {
+    int y = first + (int) ((k + 0.5) * span / scanlines);
+    res.lines++;
+    std::string text;
+    uint8_t c = readRow(&img.pixels[(size_t) y * img.width], img.width, text);
+    if (c < MIN_CONFIDENCE) continue;
+    if (votes[text]++ == 0 || c < lowest[text]) lowest[text] = c;
+  }
+
+  // Majority of the lines scanned, so a smudge can't outvote a clean print
+  for (std::map<std::string, int>::iterator it = votes.begin();
+       it != votes.end(); ++it) {
+    if (it->second > res.votes) {
+      res.votes = it->second;
+      res.text = it->first;
+      res.confidence = lowest[it->first];
+    }
+  }
+  res.ok = res.votes * 2 > res.lines;
+  return res;
+}
+
+int main(int argc, char **argv) {
+  int scanlines = DEFAULT_SCANLINES;
+  std::vector<const char *> files;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+      scanlines = atoi(argv[++i]);
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty() || scanlines < 1) {
+    fprintf(stderr, "usage: %s [-l scanlines] label.pgm...\n", argv[0]);
+    return 2;
+  }
+
+  // One result per image, each written by the one thread that took it
+  std::vector<LabelResult> results(files.size());
+  std::atomic<size_t> next(0);
+  unsigned threads = std::thread::hardware_concurrency();
+  if (threads == 0) threads = 4;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; t++) {
+    pool.push_back(std::thread([&]() {
+      Image img;
+      for (size_t i = next++; i < files.size(); i = next++) {
+        if (readPgm(files[i], img)) {
+          results[i] = decodeImage(img, scanlines);
+        } else {
+          results[i].loaded = false;
+        }
+      }
+    }));
+  }
+  for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+  double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+
+  int failed = 0;
+  for (size_t i = 0; i < files.size(); i++) {
+    const LabelResult &r = results[i];
+    if (!r.loaded) {
+      printf("%s\tUNREADABLE FILE\n", files[i]);
+      failed++;
+    } else if (!r.ok) {
+      printf("%s\tNO READ\t%d/%d\n", files[i], r.votes, r.lines);
+      failed++;
+    } else {
+      printf("%s\t%s\t%d/%d\t%d%%\n", files[i], r.text.c_str(), r.votes,
+             r.lines, r.confidence);
+    }
+  }
+  fprintf(stderr, "%zu images, %d failed, %.0f images/s on %u threads\n",
+          files.size(), failed, files.size() / secs, threads);
+  return failed ? 1 : 0;
+}